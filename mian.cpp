@@ -3,14 +3,57 @@
 #include <vector>
 #include <functional>
 #include <cassert>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#if __has_include(<execution>)
+#include <execution>
+#endif
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#if __cplusplus >= 202002L
+#include <span>
+#endif
 
 namespace timsort_detail {
 
     const int MIN_MERGE = 32;
+    const int MIN_GALLOP = 7;
+    const int MAX_MERGE_PENDING = 85; // 64 位长度下运行堆栈的最大深度
+    const std::ptrdiff_t PARALLEL_MIN_CHUNK = 1 << 14; // 并行排序时每块的最小长度
+    const std::ptrdiff_t PARALLEL_MIN_MERGE = 1 << 15; // 单次合并拆分到多个线程的最小总长度
+    const std::size_t BIDIRECTIONAL_MAX_BYTES = 1 << 18; // 双向合并需要缓冲整个合并区间，只用于能放进缓存的合并
+    const std::ptrdiff_t BIDIRECTIONAL_PROBE_LENGTH = 1 << 10; // 达到此长度的双向合并先抽样检查两侧是否几乎不交错
+    const int BIDIRECTIONAL_PROBES = 8; // 上述检查在左侧抽样的相邻元素对数
+    const std::size_t PREFETCH_MIN_BYTES = 1 << 20; // 合并区间超过此大小（约为 L2 容量）时才在逐对比较中预取
+    const std::ptrdiff_t RADIX_MIN_LENGTH = 1 << 8; // 改用基数排序的最小长度，更短时直方图与逐趟分配的固定开销不划算
+    const std::ptrdiff_t RADIX_WIDE_DIGIT_LENGTH = 1 << 16; // 达到此长度时每趟分配 11 位，减少趟数；更短时 2048 个桶的直方图开销过大
+    const int RADIX_SAMPLES = 16; // 判断输入是否接近随机时抽样检测运行的位置数（timsort_zip 也用它分派）
+    const int RADIX_MAX_SAMPLE_RUN = 8; // 任一抽样位置的自然运行达到此长度时保留 timsort
+    const int STRING_PREFIX_SAMPLES = 64; // 判断缓存的前缀能否区分字符串时抽样的字符串数，其中超过四分之一重复时改用通用路径
+    const int STRING_ORDER_SAMPLES = 64; // 判断字符串是否已大致有序时抽样比较的元素对数
+    const std::ptrdiff_t STRING_ORDER_DISTANCE = 64; // 上述每对元素相隔的距离，超过局部抖动的范围
 
     // 计算最小运行长度
-    static int minRunLength(int n) {
-        int r = 0;
+    static std::ptrdiff_t minRunLength(std::ptrdiff_t n) {
+        std::ptrdiff_t r = 0;
         while (n >= MIN_MERGE) {
             r |= (n & 1);
             n >>= 1;
@@ -18,162 +61,3084 @@ namespace timsort_detail {
         return n + r;
     }
 
-    // 二分插入排序，优化移动操作
+    // 合并时是否使用无分支的逐元素比较；可为特定类型特化以选择更快的实现
+    // 默认对不超过 32 字节的可平凡复制类型启用：复制代价低，随机数据上分支预测失败的代价更高；
+    // 近乎有序的数据主要由跳跃模式处理，逐对比较的写法对其影响不大
+    template <typename T>
+    struct BranchlessMerge : std::integral_constant<bool, std::is_trivially_copyable<T>::value && sizeof(T) <= 32> {};
+
+    // 插入排序时是否使用无分支二分查找，默认只对启用 BranchlessMerge 且不超过 16 字节的类型启用：
+    // 更大的元素插入时移动的开销占主导，省下的分支预测失败不足以抵消每次都完整二分的比较
+    template <typename T>
+    struct BranchlessInsertion : std::integral_constant<bool, BranchlessMerge<T>::value && sizeof(T) <= 16> {};
+
+    // 无分支的 upper_bound：循环次数只取决于 len，每次用条件选择收缩区间
+    template <typename T, typename RandomIt, typename Compare>
+    static RandomIt branchlessUpperBound(RandomIt base, std::ptrdiff_t len, const T& key, Compare comp) {
+        if (len == 0) return base;
+        while (len > 1) {
+            std::ptrdiff_t half = len / 2;
+            base += comp(key, base[half]) ? 0 : half;
+            len -= half;
+        }
+        return base + !comp(key, *base);
+    }
+
+    // 二分插入排序，[left, sorted) 已有序，把 [sorted, right) 逐个插入
     template <typename RandomIt, typename Compare>
-    static void binaryInsertionSort(RandomIt left, RandomIt right, Compare comp) {
-        for (auto it = left + 1; it < right; ++it) {
-            auto key = std::move(*it);
+    static void binaryInsertionSort(RandomIt left, RandomIt sorted, RandomIt right, Compare comp) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        if (sorted == left && left != right) ++sorted;
+        for (auto it = sorted; it < right; ++it) {
             // 查找插入位置
-            RandomIt pos = std::upper_bound(left, it, key, comp);
+            RandomIt pos;
+            if constexpr (BranchlessInsertion<T>::value) {
+                pos = branchlessUpperBound(left, it - left, *it, comp);
+            } else {
+                pos = std::upper_bound(left, it, *it, comp);
+            }
             // 如果插入位置不是当前元素位置，执行移动
             if (pos != it) {
+                auto key = std::move(*it);
                 std::move_backward(pos, it, it + 1);
                 *pos = std::move(key);
             }
         }
     }
 
-    // 合并两个已排序的运行，加入跳跃模式
+    // 成对插入排序：相邻两个元素先排好，较大者先插入，较小者只在较大者插入位置的左侧查找
+    // 已有序部分每次整体后移两格，移动次数约为逐个插入的一半；相等元素保持原有次序
     template <typename RandomIt, typename Compare>
-    static void mergeRuns(RandomIt start, RandomIt mid, RandomIt end, Compare comp, std::vector<typename std::iterator_traits<RandomIt>::value_type>& buffer) {
-        using ValueType = typename std::iterator_traits<RandomIt>::value_type;
-        int leftSize = static_cast<int>(mid - start);
-        int rightSize = static_cast<int>(end - mid);
+    static void pairInsertionSort(RandomIt left, RandomIt sorted, RandomIt right, Compare comp) {
+        if (sorted == left && left != right) ++sorted;
+        RandomIt it = sorted;
+        for (; right - it >= 2; it += 2) {
+            bool swapped = comp(*(it + 1), *it);
+            auto big = std::move(*(swapped ? it : it + 1));
+            auto small = std::move(*(swapped ? it + 1 : it));
 
-        // 确保缓冲区足够大
-        if (buffer.size() < static_cast<size_t>(leftSize)) {
-            buffer.resize(leftSize);
+            RandomIt bigPos = std::upper_bound(left, it, big, comp);
+            std::move_backward(bigPos, it, it + 2);
+            *(bigPos + 1) = std::move(big);
+
+            RandomIt smallPos = std::upper_bound(left, bigPos, small, comp);
+            std::move_backward(smallPos, bigPos, bigPos + 1);
+            *smallPos = std::move(small);
         }
+        binaryInsertionSort(left, it, right, comp);
+    }
 
-        // 将左半部分复制到缓冲区
-        std::move(start, mid, buffer.begin());
+#if defined(__AVX2__) || defined(__AVX512F__)
+    inline int countTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
 
-        RandomIt left = buffer.begin();
-        RandomIt leftEnd = buffer.begin() + leftSize;
-        RandomIt right = mid;
-        RandomIt rightEnd = end;
-        RandomIt dest = start;
+    // 逐元素比较 a[k] < b[k]，返回结果位掩码；每次处理 Width 个元素
+    // 浮点使用有序比较，NaN 的结果与标量 < 一致
+    template <typename T>
+    struct SimdLess;
 
-        // 实现跳跃模式
-        while (left != leftEnd && right != rightEnd) {
-            if (comp(*left, *right)) {
-                *dest++ = std::move(*left++);
+#if defined(__AVX512F__)
+    template <>
+    struct SimdLess<std::int32_t> {
+        static constexpr int Width = 16;
+        static unsigned mask(const std::int32_t* a, const std::int32_t* b) {
+            return _mm512_cmplt_epi32_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(b));
+        }
+    };
+
+    template <>
+    struct SimdLess<std::uint32_t> {
+        static constexpr int Width = 16;
+        static unsigned mask(const std::uint32_t* a, const std::uint32_t* b) {
+            return _mm512_cmplt_epu32_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(b));
+        }
+    };
+
+    template <>
+    struct SimdLess<float> {
+        static constexpr int Width = 16;
+        static unsigned mask(const float* a, const float* b) {
+            return _mm512_cmp_ps_mask(_mm512_loadu_ps(a), _mm512_loadu_ps(b), _CMP_LT_OQ);
+        }
+    };
+
+    template <>
+    struct SimdLess<double> {
+        static constexpr int Width = 8;
+        static unsigned mask(const double* a, const double* b) {
+            return _mm512_cmp_pd_mask(_mm512_loadu_pd(a), _mm512_loadu_pd(b), _CMP_LT_OQ);
+        }
+    };
+#else
+    template <>
+    struct SimdLess<std::int32_t> {
+        static constexpr int Width = 8;
+        static unsigned mask(const std::int32_t* a, const std::int32_t* b) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vb, va))));
+        }
+    };
+
+    template <>
+    struct SimdLess<std::uint32_t> {
+        static constexpr int Width = 8;
+        static unsigned mask(const std::uint32_t* a, const std::uint32_t* b) {
+            // 翻转符号位后按有符号比较
+            const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+            __m256i va = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)), bias);
+            __m256i vb = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)), bias);
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vb, va))));
+        }
+    };
+
+    template <>
+    struct SimdLess<float> {
+        static constexpr int Width = 8;
+        static unsigned mask(const float* a, const float* b) {
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b), _CMP_LT_OQ)));
+        }
+    };
+
+    template <>
+    struct SimdLess<double> {
+        static constexpr int Width = 4;
+        static unsigned mask(const double* a, const double* b) {
+            return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(a), _mm256_loadu_pd(b), _CMP_LT_OQ)));
+        }
+    };
+#endif
+#endif
+
+    // 判断迭代器是否指向连续存储
+    template <typename It, typename T>
+    struct IsContiguousIterator
+        : std::integral_constant<bool, std::is_pointer<It>::value ||
+                                       std::is_same<It, typename std::vector<T>::iterator>::value ||
+                                       std::is_same<It, typename std::vector<T>::const_iterator>::value
+#if __cplusplus >= 202002L
+                                       || std::contiguous_iterator<It>
+#endif
+                                       > {};
+
+    // 合并时软件预取的距离（元素个数），为 0 时不预取；可为特定类型特化以调整
+    // 默认约 512 字节：足以覆盖一次内存访问的延迟，又不会在运行末尾浪费太多带宽
+    template <typename T>
+    struct PrefetchDistance : std::integral_constant<std::ptrdiff_t, (512 + sizeof(T) - 1) / sizeof(T)> {};
+
+    // 预取 it 之后第 ahead 个元素所在的缓存行，forWrite 表示即将写入；只对连续存储有效，其他迭代器为空操作
+    // 预取不会触发访存异常，地址越过区间末尾也无妨，因此用整数运算求地址，避免越界的指针运算
+    template <typename Iter>
+    inline void prefetch(Iter it, std::ptrdiff_t ahead = 0, bool forWrite = false) {
+        using T = typename std::iterator_traits<Iter>::value_type;
+        if constexpr (IsContiguousIterator<Iter, T>::value && PrefetchDistance<T>::value != 0) {
+#if defined(__GNUC__) || defined(__clang__)
+            auto address = reinterpret_cast<std::uintptr_t>(std::addressof(*it)) +
+                           static_cast<std::uintptr_t>(ahead) * sizeof(T);
+            if (forWrite) {
+                __builtin_prefetch(reinterpret_cast<const void*>(address), 1, 3);
             } else {
-                *dest++ = std::move(*right++);
+                __builtin_prefetch(reinterpret_cast<const void*>(address), 0, 3);
             }
+#else
+            (void)it;
+            (void)ahead;
+            (void)forWrite;
+#endif
         }
+    }
 
-        // 复制剩余的左半部分
-        if (left != leftEnd) {
-            std::move(left, leftEnd, dest);
+    // 运行检测能否使用向量化扫描：连续存储的 int32/uint32/float/double，比较器为 std::less 或 std::greater
+    template <typename RandomIt, typename Compare, typename = void>
+    struct SimdRunScan {
+        static constexpr bool enabled = false;
+    };
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+    template <typename RandomIt, typename Compare>
+    struct SimdRunScan<RandomIt, Compare,
+                       std::void_t<decltype(SimdLess<typename std::iterator_traits<RandomIt>::value_type>::Width)>> {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        static constexpr bool less = std::is_same<Compare, std::less<T>>::value ||
+                                     std::is_same<Compare, std::less<>>::value;
+        static constexpr bool greater = std::is_same<Compare, std::greater<T>>::value ||
+                                        std::is_same<Compare, std::greater<>>::value;
+        static constexpr bool enabled = IsContiguousIterator<RandomIt, T>::value && (less || greater);
+    };
+
+    // 从 i 开始查找运行的结束位置，每次比较 Width 对相邻元素，用位掩码定位第一个破坏运行的位置
+    template <bool Greater, typename T>
+    std::ptrdiff_t simdFindRunEnd(const T* p, std::ptrdiff_t i, std::ptrdiff_t limit, bool descending) {
+        constexpr int Width = SimdLess<T>::Width;
+        const unsigned full = (1u << Width) - 1;
+        for (; i + Width <= limit; i += Width) {
+            // 第 k 位表示 comp(p[i + k], p[i + k - 1])
+            unsigned lessMask = Greater ? SimdLess<T>::mask(p + i - 1, p + i) : SimdLess<T>::mask(p + i, p + i - 1);
+            unsigned breaks = descending ? ~lessMask & full : lessMask;
+            if (breaks) return i + countTrailingZeros(breaks);
         }
-        // 右半部分的元素已经在原位置，无需复制
+        while (i < limit && (Greater ? p[i - 1] < p[i] : p[i] < p[i - 1]) == descending) ++i;
+        return i;
     }
+#endif
 
-    struct Run {
-        int start;
-        int length;
+    // 从 i（i >= 1）开始查找运行在 limit 之前的结束位置：
+    // 升序运行在第一个 comp(x[j], x[j - 1]) 处结束，严格降序运行在第一个不满足该条件处结束
+    template <typename RandomIt, typename Compare>
+    std::ptrdiff_t findRunEnd(RandomIt first, std::ptrdiff_t i, std::ptrdiff_t limit, bool descending, Compare comp) {
+#if defined(__AVX2__) || defined(__AVX512F__)
+        if constexpr (SimdRunScan<RandomIt, Compare>::enabled) {
+            return simdFindRunEnd<SimdRunScan<RandomIt, Compare>::greater>(&*first, i, limit, descending);
+        }
+#endif
+        while (i < limit && comp(*(first + i), *(first + i - 1)) == descending) ++i;
+        return i;
+    }
+
+    // 计算从 first 开始的运行长度，降序运行反转为升序
+    template <typename RandomIt, typename Compare>
+    std::ptrdiff_t countRunAndMakeAscending(RandomIt first, RandomIt last, Compare comp) {
+        std::ptrdiff_t n = last - first;
+        if (n <= 1) return n;
+        if (comp(*(first + 1), *first)) {
+            std::ptrdiff_t runLen = findRunEnd(first, 2, n, true, comp);
+            std::reverse(first, first + runLen);
+            return runLen;
+        }
+        return findRunEnd(first, 2, n, false, comp);
+    }
+
+    // 在均匀分布的若干位置检测自然运行的长度，只有每个位置的运行都很短时才认为输入接近随机：
+    // 此时 timsort 的几乎每个运行都要由插入排序补足到 minRun，运行检测无从发挥（基数排序与 timsort_zip 据此分派）。
+    // 随机数据中一处长度达到 8 的运行出现的概率约为 1/20000；近乎有序或由有序段组成的数据
+    // 至少会有一处探测到较长的运行，从而保留 timsort，不会因为抽样的平均值而误判
+    template <typename RandomIt, typename Compare>
+    bool lacksRuns(RandomIt first, std::ptrdiff_t n, Compare comp) {
+        for (int s = 0; s < RADIX_SAMPLES; ++s) {
+            std::ptrdiff_t offset = n / RADIX_SAMPLES * s;
+            std::ptrdiff_t limit = std::min<std::ptrdiff_t>(RADIX_MAX_SAMPLE_RUN, n - offset);
+            RandomIt sample = first + offset;
+            bool descending = comp(*(sample + 1), *sample);
+            if (findRunEnd(sample, 2, limit, descending, comp) == limit) return false;
+        }
+        return true;
+    }
+
+    // 二分查找 [lo, hi) 时预取下一步的两个候选中点；区间已落在少数几个缓存行内时不必预取
+    template <typename Iter>
+    inline void prefetchBisect(Iter base, std::ptrdiff_t lo, std::ptrdiff_t m, std::ptrdiff_t hi) {
+        using T = typename std::iterator_traits<Iter>::value_type;
+        if (hi - lo >= 4 && static_cast<std::size_t>(hi - lo) * sizeof(T) >= 256) {
+            prefetch(base + (lo + ((m - lo) >> 1)));
+            prefetch(base + (m + 1 + ((hi - m - 1) >> 1)));
+        }
+    }
+
+    // 逐对合并时的流预取：每输出约一个缓存行的元素，预取两个输入流与输出位置前方 distance 个元素
+    // 只在超过 PREFETCH_MIN_BYTES 的合并中启用，较小的合并数据已在缓存中，预取只会增加指令
+    template <typename T>
+    struct StreamPrefetcher {
+        std::ptrdiff_t distance; // 从后向前合并时为负，0 表示不预取
+        std::ptrdiff_t countdown = 1;
+
+        StreamPrefetcher(std::ptrdiff_t mergeLen, bool backward)
+            : distance(static_cast<std::size_t>(mergeLen) * sizeof(T) >= PREFETCH_MIN_BYTES
+                           ? (backward ? -PrefetchDistance<T>::value : PrefetchDistance<T>::value)
+                           : 0) {}
+
+        // a、b 为两个输入流的当前元素，dest 为下一个输出位置
+        template <typename IterA, typename IterB, typename IterD>
+        void step(IterA a, IterB b, IterD dest) {
+            if (distance != 0 && --countdown == 0) {
+                countdown = sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+                prefetch(a, distance);
+                prefetch(b, distance);
+                prefetch(dest, distance, true);
+            }
+        }
+    };
+
+    // 在有序区间 [base, base + len) 中查找 key 的最左插入位置，从 hint 处开始指数搜索
+    // 返回 k，满足 base[k - 1] < key <= base[k]
+    template <typename T, typename Iter, typename Compare>
+    static std::ptrdiff_t gallopLeft(const T& key, Iter base, std::ptrdiff_t len, std::ptrdiff_t hint, Compare comp) {
+        std::ptrdiff_t lastOfs = 0;
+        std::ptrdiff_t ofs = 1;
+        if (comp(base[hint], key)) {
+            // base[hint] < key，向右跳跃
+            std::ptrdiff_t maxOfs = len - hint;
+            while (ofs < maxOfs) {
+                // 跳跃距离成倍增长，下一次探测多半不在缓存中：比较当前位置前先预取，使两次未命中重叠
+                std::ptrdiff_t next = (ofs < maxOfs / 2) ? (ofs << 1) + 1 : maxOfs; // 防止溢出
+                if (next < maxOfs) prefetch(base + (hint + next));
+                if (!comp(base[hint + ofs], key)) break;
+                lastOfs = ofs;
+                ofs = next;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            lastOfs += hint;
+            ofs += hint;
+        } else {
+            // key <= base[hint]，向左跳跃
+            std::ptrdiff_t maxOfs = hint + 1;
+            while (ofs < maxOfs) {
+                std::ptrdiff_t next = (ofs < maxOfs / 2) ? (ofs << 1) + 1 : maxOfs;
+                if (next < maxOfs) prefetch(base + (hint - next));
+                if (comp(base[hint - ofs], key)) break;
+                lastOfs = ofs;
+                ofs = next;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            std::ptrdiff_t tmp = lastOfs;
+            lastOfs = hint - ofs;
+            ofs = hint - tmp;
+        }
+
+        // 此时 base[lastOfs] < key <= base[ofs]，在 (lastOfs, ofs] 内二分查找
+        ++lastOfs;
+        while (lastOfs < ofs) {
+            std::ptrdiff_t m = lastOfs + ((ofs - lastOfs) >> 1);
+            prefetchBisect(base, lastOfs, m, ofs);
+            if (comp(base[m], key)) {
+                lastOfs = m + 1;
+            } else {
+                ofs = m;
+            }
+        }
+        return ofs;
+    }
+
+    // 与 gallopLeft 相同，但返回最右插入位置
+    // 返回 k，满足 base[k - 1] <= key < base[k]
+    template <typename T, typename Iter, typename Compare>
+    static std::ptrdiff_t gallopRight(const T& key, Iter base, std::ptrdiff_t len, std::ptrdiff_t hint, Compare comp) {
+        std::ptrdiff_t lastOfs = 0;
+        std::ptrdiff_t ofs = 1;
+        if (comp(key, base[hint])) {
+            // key < base[hint]，向左跳跃
+            std::ptrdiff_t maxOfs = hint + 1;
+            while (ofs < maxOfs) {
+                std::ptrdiff_t next = (ofs < maxOfs / 2) ? (ofs << 1) + 1 : maxOfs;
+                if (next < maxOfs) prefetch(base + (hint - next));
+                if (!comp(key, base[hint - ofs])) break;
+                lastOfs = ofs;
+                ofs = next;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            std::ptrdiff_t tmp = lastOfs;
+            lastOfs = hint - ofs;
+            ofs = hint - tmp;
+        } else {
+            // base[hint] <= key，向右跳跃
+            std::ptrdiff_t maxOfs = len - hint;
+            while (ofs < maxOfs) {
+                std::ptrdiff_t next = (ofs < maxOfs / 2) ? (ofs << 1) + 1 : maxOfs;
+                if (next < maxOfs) prefetch(base + (hint + next));
+                if (comp(key, base[hint + ofs])) break;
+                lastOfs = ofs;
+                ofs = next;
+            }
+            if (ofs > maxOfs) ofs = maxOfs;
+            lastOfs += hint;
+            ofs += hint;
+        }
+
+        // 此时 base[lastOfs] <= key < base[ofs]，在 (lastOfs, ofs] 内二分查找
+        ++lastOfs;
+        while (lastOfs < ofs) {
+            std::ptrdiff_t m = lastOfs + ((ofs - lastOfs) >> 1);
+            prefetchBisect(base, lastOfs, m, ofs);
+            if (comp(key, base[m])) {
+                ofs = m;
+            } else {
+                lastOfs = m + 1;
+            }
+        }
+        return ofs;
+    }
+
+    // 合并用的临时缓冲区：未初始化的原始存储，元素只在移入时构造，
+    // 避免默认构造整块内存，也使不可默认构造的类型可以排序
+    // 存储通过 Alloc 分配；元素本身仍以移动构造放入，保留其自身的分配器
+    template <typename T, typename Alloc = std::allocator<T>>
+    class MergeBuffer {
+        using AllocTraits = std::allocator_traits<Alloc>;
+
+    public:
+        MergeBuffer() = default;
+        explicit MergeBuffer(const Alloc& alloc) : alloc_(alloc) {}
+        MergeBuffer(const MergeBuffer&) = delete;
+        MergeBuffer& operator=(const MergeBuffer&) = delete;
+
+        ~MergeBuffer() {
+            clear();
+            deallocate();
+        }
+
+        // 使用外部提供的内存作为存储。容量不足的请求改用另外分配的堆内存，
+        // 外部内存仍保留给之后能放下的请求，因此足够大的外部内存可以使排序完全不进行堆分配
+        void assign(void* storage, std::size_t bytes) {
+            clear();
+            deallocate();
+            external_ = nullptr;
+            externalCapacity_ = 0;
+            if (std::align(alignof(T), sizeof(T), storage, bytes)) {
+                external_ = static_cast<T*>(storage);
+                externalCapacity_ = static_cast<std::ptrdiff_t>(bytes / sizeof(T));
+            }
+            data_ = external_;
+        }
+
+        // 不进行分配即可容纳的元素个数
+        std::ptrdiff_t capacity() const {
+            return std::max(externalCapacity_, ownedCapacity_);
+        }
+
+        // 确保容量至少为 n 个元素；改用另一块存储或扩容时不保留旧内容
+        void reserve(std::ptrdiff_t n) {
+            if (n == 0) return;
+            T* target = n <= externalCapacity_ ? external_ : (n <= ownedCapacity_ ? owned_ : nullptr);
+            if (target && target == data_) return;
+            clear();
+            if (!target) {
+                deallocate();
+                owned_ = AllocTraits::allocate(alloc_, static_cast<std::size_t>(n));
+                ownedCapacity_ = n;
+                target = owned_;
+            }
+            data_ = target;
+        }
+
+        // 将 [first, last) 移动构造到缓冲区开头，返回首元素指针
+        template <typename Iter>
+        T* moveIn(Iter first, Iter last) {
+            clear();
+            reserve(last - first);
+            std::uninitialized_move(first, last, data_);
+            size_ = last - first;
+            return data_;
+        }
+
+        // 清空并预留 n 个元素的未初始化空间，由调用方自行构造，构造完成后调用 commit(n)
+        T* prepare(std::ptrdiff_t n) {
+            clear();
+            reserve(n);
+            return data_;
+        }
+
+        void commit(std::ptrdiff_t n) {
+            size_ = n;
+        }
+
+        // 析构缓冲区中已构造的元素（包括已被移走的元素）
+        void clear() {
+            std::destroy(data_, data_ + size_);
+            size_ = 0;
+        }
+
+    private:
+        // 释放自行分配的堆内存，外部内存不受影响
+        void deallocate() {
+            if (owned_) {
+                AllocTraits::deallocate(alloc_, owned_, static_cast<std::size_t>(ownedCapacity_));
+            }
+            if (data_ == owned_) {
+                data_ = external_;
+            }
+            owned_ = nullptr;
+            ownedCapacity_ = 0;
+        }
+
+        Alloc alloc_;
+        T* data_ = nullptr;                 // 当前使用的存储，为 external_ 或 owned_
+        std::ptrdiff_t size_ = 0;           // 已构造的元素个数
+        T* external_ = nullptr;             // 调用方提供的存储
+        std::ptrdiff_t externalCapacity_ = 0;
+        T* owned_ = nullptr;                // 本对象从 alloc_ 分配的存储
+        std::ptrdiff_t ownedCapacity_ = 0;
+    };
+
+    // 合并能否使用双调合并网络：连续存储的 int32/int64，比较器为 std::less
+    template <typename RandomIt, typename Compare, typename = void>
+    struct SimdMerge {
+        static constexpr bool enabled = false;
+    };
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+    // 双调合并网络：merge(lo, hi) 把两个升序向量合并为 lo（较小的一半）与 hi（较大的一半），均为升序；
+    // sort(v) 把一个向量排为升序
+    // 只为整数实现：浮点的 -0.0 与 +0.0 相等却可区分，NaN 也无法参与 min/max，网络会破坏稳定性
+    template <typename T>
+    struct SimdMergeNetwork;
+
+#if defined(__AVX512F__)
+    template <>
+    struct SimdMergeNetwork<std::int32_t> {
+        using Vec = __m512i;
+        static constexpr int Width = 16;
+
+        static Vec load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+        static void store(std::int32_t* p, Vec v) { _mm512_storeu_si512(p, v); }
+        static std::int32_t lowest(Vec v) { return _mm_cvtsi128_si32(_mm512_castsi512_si128(v)); }
+        static std::int32_t highest(Vec v) { return _mm_extract_epi32(_mm512_extracti32x4_epi32(v, 3), 3); }
+
+        // 比较交换：通道 i 与通道 i ^ d 比较，upper 中的通道取较大值
+        static Vec exchange(Vec v, int d, __mmask16 upper) {
+            Vec partner = _mm512_xor_si512(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+                                           _mm512_set1_epi32(d));
+            Vec s = _mm512_permutexvar_epi32(partner, v);
+            return _mm512_mask_blend_epi32(upper, _mm512_min_epi32(v, s), _mm512_max_epi32(v, s));
+        }
+
+        static Vec bitonicSort(Vec v) {
+            v = exchange(v, 8, 0xFF00);
+            v = exchange(v, 4, 0xF0F0);
+            v = exchange(v, 2, 0xCCCC);
+            return exchange(v, 1, 0xAAAA);
+        }
+
+        // 排序整个向量：每轮先做翻转比较（通道 i 与 i ^ (2k - 1)），再逐级半清洁
+        static Vec sort(Vec v) {
+            v = exchange(v, 1, 0xAAAA);
+            v = exchange(v, 3, 0xCCCC);
+            v = exchange(v, 1, 0xAAAA);
+            v = exchange(v, 7, 0xF0F0);
+            v = exchange(v, 2, 0xCCCC);
+            v = exchange(v, 1, 0xAAAA);
+            v = exchange(v, 15, 0xFF00);
+            v = exchange(v, 4, 0xF0F0);
+            v = exchange(v, 2, 0xCCCC);
+            return exchange(v, 1, 0xAAAA);
+        }
+
+        static void merge(Vec& lo, Vec& hi) {
+            Vec rev = _mm512_permutexvar_epi32(_mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), hi);
+            Vec mn = _mm512_min_epi32(lo, rev);
+            Vec mx = _mm512_max_epi32(lo, rev);
+            lo = bitonicSort(mn);
+            hi = bitonicSort(mx);
+        }
+    };
+
+    template <>
+    struct SimdMergeNetwork<std::int64_t> {
+        using Vec = __m512i;
+        static constexpr int Width = 8;
+
+        static Vec load(const std::int64_t* p) { return _mm512_loadu_si512(p); }
+        static void store(std::int64_t* p, Vec v) { _mm512_storeu_si512(p, v); }
+        static std::int64_t lowest(Vec v) { return _mm_cvtsi128_si64(_mm512_castsi512_si128(v)); }
+        static std::int64_t highest(Vec v) { return _mm256_extract_epi64(_mm512_extracti64x4_epi64(v, 1), 3); }
+
+        static Vec exchange(Vec v, int d, __mmask8 upper) {
+            Vec partner = _mm512_xor_si512(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7), _mm512_set1_epi64(d));
+            Vec s = _mm512_permutexvar_epi64(partner, v);
+            return _mm512_mask_blend_epi64(upper, _mm512_min_epi64(v, s), _mm512_max_epi64(v, s));
+        }
+
+        static Vec bitonicSort(Vec v) {
+            v = exchange(v, 4, 0xF0);
+            v = exchange(v, 2, 0xCC);
+            return exchange(v, 1, 0xAA);
+        }
+
+        static Vec sort(Vec v) {
+            v = exchange(v, 1, 0xAA);
+            v = exchange(v, 3, 0xCC);
+            v = exchange(v, 1, 0xAA);
+            v = exchange(v, 7, 0xF0);
+            v = exchange(v, 2, 0xCC);
+            return exchange(v, 1, 0xAA);
+        }
+
+        static void merge(Vec& lo, Vec& hi) {
+            Vec rev = _mm512_permutexvar_epi64(_mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0), hi);
+            Vec mn = _mm512_min_epi64(lo, rev);
+            Vec mx = _mm512_max_epi64(lo, rev);
+            lo = bitonicSort(mn);
+            hi = bitonicSort(mx);
+        }
+    };
+#else
+    template <>
+    struct SimdMergeNetwork<std::int32_t> {
+        using Vec = __m256i;
+        static constexpr int Width = 8;
+
+        static Vec load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void store(std::int32_t* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static std::int32_t lowest(Vec v) { return _mm_cvtsi128_si32(_mm256_castsi256_si128(v)); }
+        static std::int32_t highest(Vec v) { return _mm256_extract_epi32(v, 7); }
+
+        // 比较交换：通道 i 与通道 i ^ d 比较，Upper 中的通道取较大值
+        template <int Upper>
+        static Vec exchange(Vec v, int d) {
+            Vec partner = _mm256_xor_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(d));
+            Vec s = _mm256_permutevar8x32_epi32(v, partner);
+            return _mm256_blend_epi32(_mm256_min_epi32(v, s), _mm256_max_epi32(v, s), Upper);
+        }
+
+        static Vec bitonicSort(Vec v) {
+            Vec s = _mm256_permute2x128_si256(v, v, 1);
+            v = _mm256_blend_epi32(_mm256_min_epi32(v, s), _mm256_max_epi32(v, s), 0xF0);
+            s = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+            v = _mm256_blend_epi32(_mm256_min_epi32(v, s), _mm256_max_epi32(v, s), 0xCC);
+            s = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+            return _mm256_blend_epi32(_mm256_min_epi32(v, s), _mm256_max_epi32(v, s), 0xAA);
+        }
+
+        // 排序整个向量：每轮先做翻转比较（通道 i 与 i ^ (2k - 1)），再逐级半清洁
+        static Vec sort(Vec v) {
+            v = exchange<0xAA>(v, 1);
+            v = exchange<0xCC>(v, 3);
+            v = exchange<0xAA>(v, 1);
+            v = exchange<0xF0>(v, 7);
+            v = exchange<0xCC>(v, 2);
+            return exchange<0xAA>(v, 1);
+        }
+
+        static void merge(Vec& lo, Vec& hi) {
+            Vec rev = _mm256_permutevar8x32_epi32(hi, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+            Vec mn = _mm256_min_epi32(lo, rev);
+            Vec mx = _mm256_max_epi32(lo, rev);
+            lo = bitonicSort(mn);
+            hi = bitonicSort(mx);
+        }
+    };
+
+    template <>
+    struct SimdMergeNetwork<std::int64_t> {
+        using Vec = __m256i;
+        static constexpr int Width = 4;
+
+        static Vec load(const std::int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static void store(std::int64_t* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static std::int64_t lowest(Vec v) { return _mm_cvtsi128_si64(_mm256_castsi256_si128(v)); }
+        static std::int64_t highest(Vec v) { return _mm256_extract_epi64(v, 3); }
+
+        // AVX2 没有 64 位 min/max，用比较结果混合
+        static void minMax(Vec a, Vec b, Vec& mn, Vec& mx) {
+            Vec gt = _mm256_cmpgt_epi64(a, b);
+            mn = _mm256_blendv_epi8(a, b, gt);
+            mx = _mm256_blendv_epi8(b, a, gt);
+        }
+
+        // 比较交换：Partner 为 _MM_SHUFFLE 形式的通道置换，Upper 中的通道（按 32 位计）取较大值
+        template <int Partner, int Upper>
+        static Vec exchange(Vec v) {
+            Vec mn, mx;
+            minMax(v, _mm256_permute4x64_epi64(v, Partner), mn, mx);
+            return _mm256_blend_epi32(mn, mx, Upper);
+        }
+
+        static Vec bitonicSort(Vec v) {
+            v = exchange<_MM_SHUFFLE(1, 0, 3, 2), 0xF0>(v);
+            return exchange<_MM_SHUFFLE(2, 3, 0, 1), 0xCC>(v);
+        }
+
+        static Vec sort(Vec v) {
+            v = exchange<_MM_SHUFFLE(2, 3, 0, 1), 0xCC>(v);
+            v = exchange<_MM_SHUFFLE(0, 1, 2, 3), 0xF0>(v);
+            return exchange<_MM_SHUFFLE(2, 3, 0, 1), 0xCC>(v);
+        }
+
+        static void merge(Vec& lo, Vec& hi) {
+            Vec mn, mx;
+            minMax(lo, _mm256_permute4x64_epi64(hi, _MM_SHUFFLE(0, 1, 2, 3)), mn, mx);
+            lo = bitonicSort(mn);
+            hi = bitonicSort(mx);
+        }
     };
+#endif
 
     template <typename RandomIt, typename Compare>
-    void timsortImpl(RandomIt first, RandomIt last, Compare comp) {
-        int n = static_cast<int>(std::distance(first, last));
-        if (n <= 1) return;
+    struct SimdMerge<RandomIt, Compare,
+                     std::void_t<decltype(SimdMergeNetwork<typename std::iterator_traits<RandomIt>::value_type>::Width)>> {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        static constexpr bool enabled = IsContiguousIterator<RandomIt, T>::value &&
+                                        (std::is_same<Compare, std::less<T>>::value ||
+                                         std::is_same<Compare, std::less<>>::value);
+    };
+
+    // 把短序列 [y, yEnd) 与长序列 [src, srcEnd) 从前向后合并到 out，长序列中的元素成段跳跃复制
+    // out 可以与 src 重叠，但必须满足 out + (yEnd - y) <= src
+    template <typename T>
+    void gallopMergeForward(const T* y, const T* yEnd, T* src, T* srcEnd, T* out) {
+        while (y < yEnd) {
+            if (src == srcEnd) {
+                std::memmove(out, y, (yEnd - y) * sizeof(T));
+                return;
+            }
+            std::ptrdiff_t k = gallopLeft(*y, src, srcEnd - src, 0, std::less<T>());
+            std::memmove(out, src, k * sizeof(T));
+            out += k;
+            src += k;
+            *out++ = *y++;
+        }
+        if (out != src) std::memmove(out, src, (srcEnd - src) * sizeof(T));
+    }
 
-        int minRun = minRunLength(n);
-        std::vector<Run> runStack;
-        runStack.reserve(64); // 预分配足够的空间
+    // gallopMergeForward 的镜像：从后向前合并，out 指向输出区间末尾，必须满足 out - (yEnd - y) >= srcEnd
+    template <typename T>
+    void gallopMergeBackward(const T* y, const T* yEnd, T* srcBegin, T* srcEnd, T* out) {
+        while (y < yEnd) {
+            std::ptrdiff_t len = srcEnd - srcBegin;
+            if (len == 0) {
+                std::memmove(out - (yEnd - y), y, (yEnd - y) * sizeof(T));
+                return;
+            }
+            std::ptrdiff_t k = len - gallopRight(*(yEnd - 1), srcBegin, len, len - 1, std::less<T>());
+            out -= k;
+            srcEnd -= k;
+            std::memmove(out, srcEnd, k * sizeof(T));
+            *--out = *--yEnd;
+        }
+        if (out != srcEnd) std::memmove(out - (srcEnd - srcBegin), srcBegin, (srcEnd - srcBegin) * sizeof(T));
+    }
 
-        std::vector<typename std::iterator_traits<RandomIt>::value_type> buffer;
-        buffer.reserve(minRun); // 预分配缓冲区
+    // 向量化的 mergeLo：a 为缓冲区中的左侧运行，b 为原位的右侧运行，从 out 开始向后输出
+    // 每次从队首较小的一侧载入一个向量，与保留的较大一半经双调网络合并后输出较小的一半
+    // 下一整块都小于其余所有元素时跳过网络，成段复制
+    template <typename T>
+    void simdMergeForward(T* a, T* aEnd, T* b, T* bEnd, T* out) {
+        using Net = SimdMergeNetwork<T>;
+        constexpr int W = Net::Width;
+        typename Net::Vec lo = Net::load(a);
+        typename Net::Vec hi = Net::load(b);
+        a += W;
+        b += W;
+        Net::merge(lo, hi);
+        Net::store(out, lo);
+        out += W;
 
-        int start = 0;
-        while (start < n) {
-            int runLen = 1;
-
-            // 检测运行方向
-            if (start + 1 < n) {
-                if (comp(*(first + start + 1), *(first + start))) {
-                    // 降序运行，反转为升序
-                    while (start + runLen < n && comp(*(first + start + runLen), *(first + start + runLen - 1))) {
-                        runLen++;
-                    }
-                    std::reverse(first + start, first + start + runLen);
+        while (aEnd - a >= W && bEnd - b >= W) {
+            T bound = Net::lowest(hi);
+            if (*a < *b) {
+                T key = std::min(bound, *b);
+                if (a[W - 1] < key) {
+                    std::ptrdiff_t k = gallopLeft(key, a, aEnd - a, 0, std::less<T>());
+                    std::memcpy(out, a, k * sizeof(T));
+                    out += k;
+                    a += k;
+                    continue;
+                }
+                lo = Net::load(a);
+                a += W;
+            } else {
+                T key = std::min(bound, *a);
+                if (b[W - 1] < key) {
+                    std::ptrdiff_t k = gallopLeft(key, b, bEnd - b, 0, std::less<T>());
+                    std::memmove(out, b, k * sizeof(T));
+                    out += k;
+                    b += k;
+                    continue;
+                }
+                lo = Net::load(b);
+                b += W;
+            }
+            Net::merge(lo, hi);
+            Net::store(out, lo);
+            out += W;
+        }
+
+        // 收尾：保留的 hi 与较短一侧的剩余元素（都不足 2W 个）先在栈上合并，再与另一侧跳跃合并
+        T kept[W];
+        T small[2 * W];
+        Net::store(kept, hi);
+        if (aEnd - a < W) {
+            T* smallEnd = std::merge(kept, kept + W, a, aEnd, small);
+            gallopMergeForward(small, smallEnd, b, bEnd, out);
+        } else {
+            T rest[W];
+            T* restEnd = std::copy(b, bEnd, rest);
+            T* smallEnd = std::merge(kept, kept + W, rest, restEnd, small);
+            gallopMergeForward(small, smallEnd, a, aEnd, out);
+        }
+    }
+
+    // 向量化的 mergeHi：a 为原位的左侧运行，b 为缓冲区中的右侧运行，从 out 开始向前输出
+    template <typename T>
+    void simdMergeBackward(T* aBegin, T* a, T* bBegin, T* b, T* out) {
+        using Net = SimdMergeNetwork<T>;
+        constexpr int W = Net::Width;
+        a -= W;
+        b -= W;
+        typename Net::Vec lo = Net::load(a);
+        typename Net::Vec hi = Net::load(b);
+        Net::merge(lo, hi);
+        out -= W;
+        Net::store(out, hi);
+
+        while (a - aBegin >= W && b - bBegin >= W) {
+            T bound = Net::highest(lo);
+            if (*(b - 1) < *(a - 1)) {
+                T key = std::max(bound, *(b - 1));
+                if (key < *(a - W)) {
+                    std::ptrdiff_t len = a - aBegin;
+                    std::ptrdiff_t k = len - gallopRight(key, aBegin, len, len - 1, std::less<T>());
+                    out -= k;
+                    a -= k;
+                    std::memmove(out, a, k * sizeof(T));
+                    continue;
+                }
+                a -= W;
+                hi = Net::load(a);
+            } else {
+                T key = std::max(bound, *(a - 1));
+                if (key < *(b - W)) {
+                    std::ptrdiff_t len = b - bBegin;
+                    std::ptrdiff_t k = len - gallopRight(key, bBegin, len, len - 1, std::less<T>());
+                    out -= k;
+                    b -= k;
+                    std::memcpy(out, b, k * sizeof(T));
+                    continue;
+                }
+                b -= W;
+                hi = Net::load(b);
+            }
+            Net::merge(lo, hi);
+            out -= W;
+            Net::store(out, hi);
+        }
+
+        T kept[W];
+        T small[2 * W];
+        Net::store(kept, lo);
+        if (b - bBegin < W) {
+            T* smallEnd = std::merge(bBegin, b, kept, kept + W, small);
+            gallopMergeBackward(small, smallEnd, aBegin, a, out);
+        } else {
+            T rest[W];
+            T* restEnd = std::copy(aBegin, a, rest);
+            T* smallEnd = std::merge(rest, restEnd, kept, kept + W, small);
+            gallopMergeBackward(small, smallEnd, bBegin, b, out);
+        }
+    }
+
+    // 用排序网络构建短块：每 Width 个元素在寄存器内排序，再自底向上两两合并
+    // n 不超过 2 * MIN_MERGE，左半段复制到栈上后与原位的右半段合并
+    template <typename T>
+    void simdSmallSort(T* p, std::ptrdiff_t n) {
+        using Net = SimdMergeNetwork<T>;
+        constexpr int W = Net::Width;
+        std::ptrdiff_t full = n - n % W;
+        for (std::ptrdiff_t i = 0; i < full; i += W) {
+            Net::store(p + i, Net::sort(Net::load(p + i)));
+        }
+        binaryInsertionSort(p + full, p + full, p + n, std::less<T>());
+
+        T left[MIN_MERGE];
+        for (std::ptrdiff_t width = W; width < n; width *= 2) {
+            for (std::ptrdiff_t lo = 0; lo + width < n; lo += 2 * width) {
+                std::ptrdiff_t hi = std::min(lo + 2 * width, n);
+                std::memcpy(left, p + lo, width * sizeof(T));
+                if (hi - lo - width >= W) {
+                    simdMergeForward(left, left + width, p + lo + width, p + hi, p + lo);
                 } else {
-                    // 升序运行
-                    while (start + runLen < n && !comp(*(first + start + runLen), *(first + start + runLen - 1))) {
-                        runLen++;
+                    // 右半段不足一个向量：无分支的逐元素合并
+                    T* a = left;
+                    T* aEnd = left + width;
+                    T* b = p + lo + width;
+                    T* bEnd = p + hi;
+                    T* out = p + lo;
+                    while (a < aEnd && b < bEnd) {
+                        bool takeB = *b < *a;
+                        *out++ = takeB ? *b : *a;
+                        b += takeB;
+                        a += !takeB;
                     }
+                    std::memcpy(out, a, (aEnd - a) * sizeof(T));
                 }
             }
+        }
+    }
+#endif
 
-            // 如果运行长度小于最小运行长度，进行扩展
-            if (runLen < minRun) {
-                int force = std::min(minRun, n - start);
-                binaryInsertionSort(first + start, first + start + force, comp);
-                runLen = force;
+    // 把短运行 [first, sorted) 扩展为有序的 [first, last)，用于构建 minRun 长度的块
+    // int32/int64 使用排序网络；可平凡复制的小类型使用无分支二分插入；其余类型使用成对插入
+    template <typename RandomIt, typename Compare>
+    static void smallSort(RandomIt first, RandomIt sorted, RandomIt last, Compare comp) {
+        if (last - first <= 1) return;
+#if defined(__AVX2__) || defined(__AVX512F__)
+        if constexpr (SimdMerge<RandomIt, Compare>::enabled) {
+            if (last - first <= 2 * MIN_MERGE) {
+                simdSmallSort(&*first, last - first);
+                return;
             }
+        }
+#endif
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        if constexpr (BranchlessInsertion<T>::value) {
+            binaryInsertionSort(first, sorted, last, comp);
+        } else {
+            pairInsertionSort(first, sorted, last, comp);
+        }
+    }
 
-            // 将当前运行压入堆栈
-            runStack.push_back(Run{ start, runLen });
+    // 从前向后合并，缓冲左侧运行，适用于左侧较短的情况
+    // 调用前需已完成裁剪：run2[0] < run1[0]，且 run1 最后一个元素大于 run2 的所有元素
+    // minGallop 在整个排序过程中自适应：跳跃有效时降低，无效时升高
+    template <typename RandomIt, typename Compare, typename Buffer>
+    static void mergeLo(RandomIt start, RandomIt mid, RandomIt end, Compare comp, Buffer& buffer, int& minGallop) {
+        std::ptrdiff_t leftSize = mid - start;
 
-            // 合并运行，维护 Timsort 的堆栈不变量
-            while (runStack.size() > 1) {
-                int size = static_cast<int>(runStack.size());
-                bool shouldMerge = false;
-
-                if (size >= 3) {
-                    int A = runStack[size - 3].length;
-                    int B = runStack[size - 2].length;
-                    int C = runStack[size - 1].length;
-                    if (A <= B + C) {
-                        shouldMerge = true;
+#if defined(__AVX2__) || defined(__AVX512F__)
+        if constexpr (SimdMerge<RandomIt, Compare>::enabled) {
+            using T = typename std::iterator_traits<RandomIt>::value_type;
+            if (std::min(leftSize, end - mid) >= SimdMergeNetwork<T>::Width) {
+                T* left = buffer.moveIn(start, mid);
+                simdMergeForward(left, left + leftSize, &*mid, &*mid + (end - mid), &*start);
+                buffer.clear();
+                return;
+            }
+        }
+#endif
+
+        // 将左半部分移动到缓冲区
+        auto left = buffer.moveIn(start, mid);
+        auto leftEnd = left + leftSize;
+        RandomIt right = mid;
+        RandomIt rightEnd = end;
+        RandomIt dest = start;
+        StreamPrefetcher<typename std::iterator_traits<RandomIt>::value_type> prefetcher(end - start, false);
+
+        // 裁剪后 run2[0] 一定小于左侧所有元素
+        *dest++ = std::move(*right++);
+        if (right == rightEnd) goto done;
+
+        while (true) {
+            std::ptrdiff_t count1 = 0; // 左侧连续胜出次数
+            std::ptrdiff_t count2 = 0; // 右侧连续胜出次数
+
+            // 逐个比较，直到某一侧连续胜出 minGallop 次
+            if constexpr (BranchlessMerge<typename std::iterator_traits<RandomIt>::value_type>::value) {
+                // 用条件选择代替分支：随机数据上比较结果不可预测
+                do {
+                    prefetcher.step(left, right, dest);
+                    bool takeRight = comp(*right, *left);
+                    *dest++ = *(takeRight ? &*right : &*left);
+                    right += takeRight;
+                    left += !takeRight;
+                    count2 = (count2 + 1) & -static_cast<std::ptrdiff_t>(takeRight);
+                    count1 = (count1 + 1) & -static_cast<std::ptrdiff_t>(!takeRight);
+                } while (right != rightEnd && left != leftEnd && (count1 | count2) < minGallop);
+                if (right == rightEnd || left == leftEnd) goto done;
+            } else {
+                do {
+                    prefetcher.step(left, right, dest);
+                    if (comp(*right, *left)) {
+                        *dest++ = std::move(*right++);
+                        ++count2;
+                        count1 = 0;
+                        if (right == rightEnd) goto done;
+                    } else {
+                        *dest++ = std::move(*left++);
+                        ++count1;
+                        count2 = 0;
+                        if (left == leftEnd) goto done;
                     }
+                } while ((count1 | count2) < minGallop);
+            }
+
+            // 实现跳跃模式：用指数搜索找出整块胜出的元素并批量移动
+            ++minGallop;
+            do {
+                minGallop -= minGallop > 1;
+
+                count1 = gallopRight(*right, left, leftEnd - left, 0, comp);
+                if (count1 != 0) {
+                    dest = std::move(left, left + count1, dest);
+                    left += count1;
+                    if (left == leftEnd) goto done;
                 }
-                if (!shouldMerge && size >= 2) {
-                    int B = runStack[size - 2].length;
-                    int C = runStack[size - 1].length;
-                    if (B <= C) {
-                        shouldMerge = true;
-                    }
+                *dest++ = std::move(*right++);
+                if (right == rightEnd) goto done;
+
+                count2 = gallopLeft(*left, right, rightEnd - right, 0, comp);
+                if (count2 != 0) {
+                    dest = std::move(right, right + count2, dest);
+                    right += count2;
+                    if (right == rightEnd) goto done;
                 }
+                *dest++ = std::move(*left++);
+                if (left == leftEnd) goto done;
+            } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+
+            // 跳跃不再划算，提高进入跳跃模式的门槛
+            ++minGallop;
+        }
 
-                if (shouldMerge) {
-                    // 弹出最后两个运行进行合并
-                    Run run2 = runStack.back(); runStack.pop_back();
-                    Run run1 = runStack.back(); runStack.pop_back();
+    done:
+        // 复制剩余的左半部分
+        if (left != leftEnd) {
+            std::move(left, leftEnd, dest);
+        }
+        // 右半部分的元素已经在原位置，无需复制
+        buffer.clear();
+    }
 
-                    mergeRuns(first + run1.start, first + run1.start + run1.length,
-                              first + run1.start + run1.length + run2.length, comp, buffer);
+    // 从后向前合并，缓冲右侧运行，适用于右侧较短的情况，前置条件与 mergeLo 相同
+    template <typename RandomIt, typename Compare, typename Buffer>
+    static void mergeHi(RandomIt start, RandomIt mid, RandomIt end, Compare comp, Buffer& buffer, int& minGallop) {
+        std::ptrdiff_t rightSize = end - mid;
 
-                    // 将合并后的运行压入堆栈
-                    runStack.push_back(Run{ run1.start, run1.length + run2.length });
-                } else {
-                    break;
-                }
+#if defined(__AVX2__) || defined(__AVX512F__)
+        if constexpr (SimdMerge<RandomIt, Compare>::enabled) {
+            using T = typename std::iterator_traits<RandomIt>::value_type;
+            if (std::min(mid - start, rightSize) >= SimdMergeNetwork<T>::Width) {
+                T* right = buffer.moveIn(mid, end);
+                simdMergeBackward(&*start, &*start + (mid - start), right, right + rightSize, &*start + (end - start));
+                buffer.clear();
+                return;
             }
-
-            start += runLen;
         }
+#endif
 
-        // 最终合并所有运行
-        while (runStack.size() > 1) {
-            // 弹出最后两个运行进行合并
-            Run run2 = runStack.back(); runStack.pop_back();
-            Run run1 = runStack.back(); runStack.pop_back();
+        // 将右半部分移动到缓冲区
+        auto rightBegin = buffer.moveIn(mid, end);
+        auto right = rightBegin + rightSize; // 右侧未合并部分为 [rightBegin, right)
+        RandomIt left = mid;                 // 左侧未合并部分为 [start, left)
+        RandomIt dest = end;
+        StreamPrefetcher<typename std::iterator_traits<RandomIt>::value_type> prefetcher(end - start, true);
+
+        // 裁剪后 run1 最后一个元素一定大于右侧所有元素
+        *--dest = std::move(*--left);
+        if (left == start) goto done;
+
+        while (true) {
+            std::ptrdiff_t count1 = 0; // 左侧连续胜出次数
+            std::ptrdiff_t count2 = 0; // 右侧连续胜出次数
+
+            // 逐个比较，直到某一侧连续胜出 minGallop 次
+            if constexpr (BranchlessMerge<typename std::iterator_traits<RandomIt>::value_type>::value) {
+                do {
+                    prefetcher.step(left - 1, right - 1, dest - 1);
+                    bool takeLeft = comp(*(right - 1), *(left - 1));
+                    *--dest = *(takeLeft ? &*(left - 1) : &*(right - 1));
+                    left -= takeLeft;
+                    right -= !takeLeft;
+                    count1 = (count1 + 1) & -static_cast<std::ptrdiff_t>(takeLeft);
+                    count2 = (count2 + 1) & -static_cast<std::ptrdiff_t>(!takeLeft);
+                } while (left != start && right != rightBegin && (count1 | count2) < minGallop);
+                if (left == start || right == rightBegin) goto done;
+            } else {
+                do {
+                    prefetcher.step(left - 1, right - 1, dest - 1);
+                    if (comp(*(right - 1), *(left - 1))) {
+                        *--dest = std::move(*--left);
+                        ++count1;
+                        count2 = 0;
+                        if (left == start) goto done;
+                    } else {
+                        *--dest = std::move(*--right);
+                        ++count2;
+                        count1 = 0;
+                        if (right == rightBegin) goto done;
+                    }
+                } while ((count1 | count2) < minGallop);
+            }
+
+            // 跳跃模式，方向与 mergeLo 相反
+            ++minGallop;
+            do {
+                minGallop -= minGallop > 1;
+
+                std::ptrdiff_t leftLen = left - start;
+                count1 = leftLen - gallopRight(*(right - 1), start, leftLen, leftLen - 1, comp);
+                if (count1 != 0) {
+                    dest = std::move_backward(left - count1, left, dest);
+                    left -= count1;
+                    if (left == start) goto done;
+                }
+                *--dest = std::move(*--right);
+                if (right == rightBegin) goto done;
+
+                std::ptrdiff_t rightLen = right - rightBegin;
+                count2 = rightLen - gallopLeft(*(left - 1), rightBegin, rightLen, rightLen - 1, comp);
+                if (count2 != 0) {
+                    dest -= count2;
+                    right -= count2;
+                    std::move(right, right + count2, dest);
+                    if (right == rightBegin) goto done;
+                }
+                *--dest = std::move(*--left);
+                if (left == start) goto done;
+            } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
 
-            mergeRuns(first + run1.start, first + run1.start + run1.length,
-                      first + run1.start + run1.length + run2.length, comp, buffer);
+            // 跳跃不再划算，提高进入跳跃模式的门槛
+            ++minGallop;
+        }
 
-            // 将合并后的运行压入堆栈
-            runStack.push_back(Run{ run1.start, run1.length + run2.length });
+    done:
+        // 复制剩余的右半部分
+        if (right != rightBegin) {
+            std::move(rightBegin, right, dest - (right - rightBegin));
         }
+        // 左半部分的元素已经在原位置，无需复制
+        buffer.clear();
     }
 
-} // namespace timsort_detail
+    // 合并时是否允许双向合并；默认与 BranchlessMerge 相同，可为特定类型特化
+    template <typename T>
+    struct BidirectionalMerge : BranchlessMerge<T> {};
 
-// 对外接口，简化使用
-template <typename RandomIt, typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
-void timsort(RandomIt first, RandomIt last, Compare comp = Compare()) {
-    timsort_detail::timsortImpl(first, last, comp);
+    // 双向合并：两个运行都移入缓冲区，每轮同时从前端取最小值、从后端取最大值，
+    // 两条互不依赖的比较链可以被乱序执行的处理器重叠。原位合并只有一端有空位，因此只用于能完整缓冲的合并
+    // 相等元素前端取左侧、后端取右侧，保持稳定
+    template <typename RandomIt, typename Compare, typename Buffer>
+    static void bidirectionalMerge(RandomIt start, RandomIt mid, RandomIt end, Compare comp, Buffer& buffer,
+                                   int& minGallop) {
+        std::ptrdiff_t leftSize = mid - start;
+        std::ptrdiff_t n = end - start;
+        auto scratch = buffer.moveIn(start, end);
+        auto left = scratch;
+        auto leftLast = scratch + leftSize - 1;
+        auto right = scratch + leftSize;
+        auto rightLast = scratch + n - 1;
+        RandomIt front = start;
+        RandomIt back = end - 1;
+
+        // 较短一侧的长度内两端都不会越过任一运行的边界
+        std::ptrdiff_t steps = std::min(leftSize, n - leftSize);
+        std::ptrdiff_t switches = 0;
+        bool lastTakeRight = false;
+        for (std::ptrdiff_t i = 0; i < steps; ++i) {
+            bool takeRight = comp(*right, *left);
+            *front++ = *(takeRight ? right : left);
+            right += takeRight;
+            left += !takeRight;
+            switches += takeRight != lastTakeRight;
+            lastTakeRight = takeRight;
+
+            bool takeLeft = comp(*rightLast, *leftLast);
+            *back-- = *(takeLeft ? leftLast : rightLast);
+            leftLast -= takeLeft;
+            rightLast -= !takeLeft;
+        }
+
+        // 中间剩余部分单向合并
+        while (left <= leftLast && right <= rightLast) {
+            bool takeRight = comp(*right, *left);
+            *front++ = *(takeRight ? right : left);
+            right += takeRight;
+            left += !takeRight;
+        }
+        front = std::copy(left, leftLast + 1, front);
+        std::copy(right, rightLast + 1, front);
+        buffer.clear();
+
+        // 平均连续胜出长度足够长时，说明数据适合跳跃，后续合并改用带跳跃模式的 mergeLo/mergeHi
+        if (steps >= MIN_GALLOP && switches * MIN_GALLOP < steps) {
+            minGallop = MIN_GALLOP - 1;
+        }
+    }
+
+    // 抽样估计两个运行是否几乎不交错：在左侧均匀取若干相邻元素对，检查右侧是否有元素落在两者之间。
+    // 近乎有序的数据中，裁剪后的两端常各有几个错位元素，中间却是大段连续胜出；
+    // 这时带跳跃的合并只需少量比较，双向合并反而要逐个比较整个区间
+    template <typename RandomIt, typename Compare>
+    static bool mostlyDisjoint(RandomIt start, RandomIt mid, RandomIt end, Compare comp) {
+        std::ptrdiff_t leftSize = mid - start;
+        if (leftSize < 2) return true;
+        int interleaved = 0;
+        for (int s = 0; s < BIDIRECTIONAL_PROBES; ++s) {
+            RandomIt a = start + (leftSize - 1) * s / BIDIRECTIONAL_PROBES;
+            RandomIt b = std::lower_bound(mid, end, *a, comp);
+            interleaved += b != end && comp(*b, *(a + 1));
+        }
+        return interleaved <= 1;
+    }
+
+    template <typename RandomIt, typename Compare, typename Buffer>
+    static void mergeRuns(RandomIt start, RandomIt mid, RandomIt end, Compare comp, Buffer& buffer, int& minGallop,
+                          std::ptrdiff_t maxBuffer);
+
+    // 缓冲区受限时的原地合并：按较长一侧的中点切分，通过旋转交换中间两段后递归合并，
+    // 子问题的较短一侧能放入缓冲区时回到带缓冲的合并
+    template <typename RandomIt, typename Compare, typename Buffer>
+    static void mergeInPlace(RandomIt start, RandomIt mid, RandomIt end, Compare comp, Buffer& buffer, int& minGallop,
+                             std::ptrdiff_t maxBuffer) {
+        while (start != mid && mid != end) {
+            std::ptrdiff_t len1 = mid - start;
+            std::ptrdiff_t len2 = end - mid;
+            if (std::min(len1, len2) <= maxBuffer) {
+                mergeRuns(start, mid, end, comp, buffer, minGallop, maxBuffer);
+                return;
+            }
+            if (len1 + len2 == 2) {
+                if (comp(*mid, *start)) std::iter_swap(start, mid);
+                return;
+            }
+
+            RandomIt cut1;
+            RandomIt cut2;
+            if (len1 > len2) {
+                cut1 = start + len1 / 2;
+                cut2 = mid + gallopLeft(*cut1, mid, len2, 0, comp);
+            } else {
+                cut2 = mid + len2 / 2;
+                cut1 = start + gallopRight(*cut2, start, len1, len1 - 1, comp);
+            }
+            RandomIt newMid = std::rotate(cut1, mid, cut2);
+
+            // 递归处理较短的子问题，循环处理较长的子问题，使递归深度为 O(log n)
+            if ((newMid - start) < (end - newMid)) {
+                mergeInPlace(start, cut1, newMid, comp, buffer, minGallop, maxBuffer);
+                start = newMid;
+                mid = cut2;
+            } else {
+                mergeInPlace(newMid, cut2, end, comp, buffer, minGallop, maxBuffer);
+                end = newMid;
+                mid = cut1;
+            }
+        }
+    }
+
+    // 合并两个已排序的运行，加入跳跃模式
+    // 先裁剪掉已在最终位置的元素，再只缓冲较短的一侧；较短一侧超过 maxBuffer 时改为原地合并
+    template <typename RandomIt, typename Compare, typename Buffer>
+    static void mergeRuns(RandomIt start, RandomIt mid, RandomIt end, Compare comp, Buffer& buffer, int& minGallop,
+                          std::ptrdiff_t maxBuffer) {
+        // 预先裁剪：run2[0] 之前的左侧元素已在最终位置
+        std::ptrdiff_t k = gallopRight(*mid, start, mid - start, 0, comp);
+        start += k;
+        if (start == mid) return;
+
+        // run1 最后一个元素之后的右侧元素也已在最终位置
+        end = mid + gallopLeft(*(mid - 1), mid, end - mid, (end - mid) - 1, comp);
+        if (end == mid) return;
+
+        // 可平凡复制的小类型在缓存内的合并使用双向合并；跳跃有效时（minGallop 较低，或抽样显示两侧几乎不交错）
+        // 仍用带跳跃的合并。双向合并要缓冲整个区间，是单向合并的两倍，只在缓冲区已有足够容量时使用，
+        // 不为它扩容，调用方按较短一侧准备的内存（例如 timsort_context 的外部存储）因此不会不够用
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        if constexpr (BidirectionalMerge<T>::value && !SimdMerge<RandomIt, Compare>::enabled) {
+            std::ptrdiff_t n = end - start;
+            if (minGallop >= MIN_GALLOP && n <= maxBuffer && n <= buffer.capacity() &&
+                static_cast<std::size_t>(n) * sizeof(T) <= BIDIRECTIONAL_MAX_BYTES &&
+                !(n >= BIDIRECTIONAL_PROBE_LENGTH && mostlyDisjoint(start, mid, end, comp))) {
+                bidirectionalMerge(start, mid, end, comp, buffer, minGallop);
+                return;
+            }
+        }
+
+        if (std::min(mid - start, end - mid) > maxBuffer) {
+            mergeInPlace(start, mid, end, comp, buffer, minGallop, maxBuffer);
+        } else if (mid - start <= end - mid) {
+            mergeLo(start, mid, end, comp, buffer, minGallop);
+        } else {
+            mergeHi(start, mid, end, comp, buffer, minGallop);
+        }
+    }
+
+    struct Run {
+        std::ptrdiff_t start;
+        std::ptrdiff_t length;
+        int power; // 仅 Powersort 使用：该运行与其后运行之间边界的节点深度
+    };
+
+    // 经典 Timsort 合并策略，维护 A > B + C 且 B > C 的堆栈不变量
+    // 额外检查更深一层的运行，并让 B 与 A、C 中较短者合并，避免朴素写法破坏不变量
+    struct ClassicMergePolicy {
+        template <typename Stack, typename MergeAt>
+        static void pushRun(Stack& runStack, Run run, std::ptrdiff_t /* n */, MergeAt mergeAt) {
+            runStack.push_back(run);
+            while (runStack.size() > 1) {
+                int i = static_cast<int>(runStack.size()) - 2;
+                if ((i > 0 && runStack[i - 1].length <= runStack[i].length + runStack[i + 1].length) ||
+                    (i > 1 && runStack[i - 2].length <= runStack[i - 1].length + runStack[i].length)) {
+                    if (runStack[i - 1].length < runStack[i + 1].length) {
+                        --i;
+                    }
+                    mergeAt(i);
+                } else if (runStack[i].length <= runStack[i + 1].length) {
+                    mergeAt(i);
+                } else {
+                    break;
+                }
+            }
+        }
+    };
+
+    // Powersort 合并策略（CPython 3.11 起使用），按运行边界在近似最优合并树中的深度决定合并顺序
+    struct PowersortMergePolicy {
+        // 计算 [s1, s1 + n1) 与 [s1 + n1, s1 + n1 + n2) 两个相邻运行之间边界的深度
+        static int nodePower(std::ptrdiff_t s1, std::ptrdiff_t n1, std::ptrdiff_t n2, std::ptrdiff_t n) {
+            int result = 0;
+            std::ptrdiff_t a = 2 * s1 + n1;  // 左运行中点的两倍
+            std::ptrdiff_t b = a + n1 + n2;  // 右运行中点的两倍
+            while (true) {
+                ++result;
+                if (a >= n) {
+                    // 两个中点的当前二进制位都为 1
+                    a -= n;
+                    b -= n;
+                } else if (b >= n) {
+                    // 二进制位首次不同
+                    break;
+                }
+                a <<= 1;
+                b <<= 1;
+            }
+            return result;
+        }
+
+        template <typename Stack, typename MergeAt>
+        static void pushRun(Stack& runStack, Run run, std::ptrdiff_t n, MergeAt mergeAt) {
+            if (!runStack.empty()) {
+                const Run& top = runStack.back();
+                int power = nodePower(top.start, top.length, run.length, n);
+                while (runStack.size() > 1 && runStack[runStack.size() - 2].power > power) {
+                    mergeAt(static_cast<int>(runStack.size()) - 2);
+                }
+                runStack.back().power = power;
+            }
+            runStack.push_back(run);
+        }
+    };
+
+    // 单次排序的选项
+    struct SortOptions {
+        // 合并缓冲区的内存上限（字节），超出时对应的合并改为原地进行
+        std::size_t max_scratch_bytes = SIZE_MAX;
+    };
+
+    // 排序所需的全部可复用状态：合并缓冲区与运行堆栈，两者都从 Alloc 分配
+    // 跨多次调用复用时，稳定状态下排序不再进行堆分配
+    template <typename T, typename Alloc = std::allocator<T>>
+    struct SortContext {
+        using BufferAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+        using RunAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Run>;
+
+        SortContext() = default;
+        explicit SortContext(const Alloc& alloc) : buffer(BufferAlloc(alloc)), runStack(RunAlloc(alloc)) {}
+#if __cplusplus >= 202002L
+        // 使用调用方提供的内存作为合并缓冲区。合并只缓冲较短的一侧，按 T 对齐、至少 n / 2 * sizeof(T) 字节
+        // （n 为单次排序的最大元素个数）时排序不进行任何堆分配；运行堆栈在构造时预留。
+        // 内存较小时，放不下的合并改用从 alloc 分配并保留的堆内存，放得下的合并仍使用这块内存
+        explicit SortContext(std::span<std::byte> scratch, const Alloc& alloc = Alloc()) : SortContext(alloc) {
+            buffer.assign(scratch.data(), scratch.size());
+            runStack.reserve(MAX_MERGE_PENDING);
+        }
+#endif
+        SortContext(const SortContext&) = delete;
+        SortContext& operator=(const SortContext&) = delete;
+
+        MergeBuffer<T, BufferAlloc> buffer;
+        std::vector<Run, RunAlloc> runStack;
+    };
+
+    // 固定容量的内联合并缓冲区，接口与 MergeBuffer 相同，不进行任何堆分配
+    template <typename T, std::ptrdiff_t Capacity>
+    class InlineBuffer {
+    public:
+        InlineBuffer() = default;
+        InlineBuffer(const InlineBuffer&) = delete;
+        InlineBuffer& operator=(const InlineBuffer&) = delete;
+
+        ~InlineBuffer() {
+            clear();
+        }
+
+        std::ptrdiff_t capacity() const {
+            return Capacity;
+        }
+
+        void reserve(std::ptrdiff_t n) {
+            assert(n <= Capacity);
+            (void)n;
+        }
+
+        template <typename Iter>
+        T* moveIn(Iter first, Iter last) {
+            clear();
+            reserve(last - first);
+            std::uninitialized_move(first, last, data());
+            size_ = last - first;
+            return data();
+        }
+
+        void clear() {
+            std::destroy(data(), data() + size_);
+            size_ = 0;
+        }
+
+    private:
+        T* data() {
+            return std::launder(reinterpret_cast<T*>(storage_));
+        }
+
+        alignas(T) unsigned char storage_[Capacity * sizeof(T)];
+        std::ptrdiff_t size_ = 0;
+    };
+
+    // 固定容量的运行堆栈，提供 timsortImpl 与合并策略用到的 vector 接口
+    class FixedRunStack {
+    public:
+        void clear() { size_ = 0; }
+        void reserve(std::size_t) {}
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        Run* begin() { return runs_; }
+        Run& back() { return runs_[size_ - 1]; }
+        Run& operator[](std::size_t i) { return runs_[i]; }
+        const Run& operator[](std::size_t i) const { return runs_[i]; }
+
+        void push_back(const Run& run) {
+            assert(size_ < static_cast<std::size_t>(MAX_MERGE_PENDING));
+            runs_[size_++] = run;
+        }
+
+        void erase(Run* pos) {
+            std::move(pos + 1, runs_ + size_, pos);
+            --size_;
+        }
+
+    private:
+        Run runs_[MAX_MERGE_PENDING];
+        std::size_t size_ = 0;
+    };
+
+    // 原地排序的缓冲区字节数，只占用固定大小的栈空间
+    const std::size_t INPLACE_BUFFER_BYTES = 4096;
+
+    // 原地排序使用的上下文：固定大小的缓冲区与运行堆栈
+    template <typename T>
+    struct InplaceContext {
+        static constexpr std::ptrdiff_t BufferLength =
+            sizeof(T) < INPLACE_BUFFER_BYTES ? static_cast<std::ptrdiff_t>(INPLACE_BUFFER_BYTES / sizeof(T)) : 1;
+
+        InlineBuffer<T, BufferLength> buffer;
+        FixedRunStack runStack;
+    };
+
+    // 判断类型是否满足分配器的基本要求，用于区分重载
+    template <typename A, typename = void>
+    struct IsAllocator : std::false_type {};
+
+    template <typename A>
+    struct IsAllocator<A, std::void_t<typename A::value_type, decltype(std::declval<A&>().allocate(std::size_t{}))>>
+        : std::true_type {};
+
+    template <typename Policy, typename RandomIt, typename Compare, typename Context>
+    void timsortImpl(RandomIt first, RandomIt last, Compare comp, Context& ctx,
+                     const SortOptions& options = SortOptions()) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        std::ptrdiff_t n = std::distance(first, last);
+        if (n <= 1) return;
+
+        std::ptrdiff_t minRun = minRunLength(n);
+        auto& runStack = ctx.runStack;
+        runStack.clear();
+        runStack.reserve(MAX_MERGE_PENDING); // 预分配足够的空间
+
+        // 缓冲区最多容纳的元素个数
+        std::ptrdiff_t maxBuffer = static_cast<std::ptrdiff_t>(
+            std::min<std::size_t>(options.max_scratch_bytes / sizeof(T), PTRDIFF_MAX));
+
+        auto& buffer = ctx.buffer;
+        buffer.reserve(std::min({ minRun, maxBuffer, n / 2 })); // 预分配缓冲区，合并的较短一侧不超过 n / 2
+        int minGallop = MIN_GALLOP;
+
+        // 合并堆栈中第 i 与第 i + 1 个运行
+        auto mergeAt = [&](int i) {
+            Run& run1 = runStack[i];
+            const Run& run2 = runStack[i + 1];
+            mergeRuns(first + run1.start, first + run2.start, first + run2.start + run2.length,
+                      comp, buffer, minGallop, maxBuffer);
+            run1.length += run2.length;
+            runStack.erase(runStack.begin() + i + 1);
+        };
+
+        std::ptrdiff_t start = 0;
+        while (start < n) {
+            // 检测运行长度，降序运行反转为升序
+            std::ptrdiff_t runLen = countRunAndMakeAscending(first + start, last, comp);
+
+            // 如果运行长度小于最小运行长度，进行扩展
+            if (runLen < minRun) {
+                std::ptrdiff_t force = std::min(minRun, n - start);
+                smallSort(first + start, first + start + runLen, first + start + force, comp);
+                runLen = force;
+            }
+
+            // 将当前运行压入堆栈，并按合并策略合并运行
+            Policy::pushRun(runStack, Run{ start, runLen, 0 }, n, mergeAt);
+
+            start += runLen;
+        }
+
+        // 最终合并所有运行
+        while (runStack.size() > 1) {
+            mergeAt(static_cast<int>(runStack.size()) - 2);
+        }
+    }
+
+    // Chase-Lev 工作窃取双端队列：所有者线程在底部压入与弹出，其他线程从顶部窃取
+    // 扩容后的旧数组保留到队列析构，窃取者读到旧数组也是安全的
+    template <typename T>
+    class ChaseLevDeque {
+        struct Array {
+            explicit Array(std::int64_t capacity) : capacity(capacity), slots(new std::atomic<T*>[capacity]) {}
+
+            T* get(std::int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+            void put(std::int64_t i, T* item) { slots[i & (capacity - 1)].store(item, std::memory_order_relaxed); }
+
+            std::int64_t capacity;
+            std::unique_ptr<std::atomic<T*>[]> slots;
+        };
+
+    public:
+        explicit ChaseLevDeque(std::int64_t capacity = 256) {
+            arrays_.emplace_back(new Array(capacity));
+            array_.store(arrays_.back().get(), std::memory_order_relaxed);
+        }
+
+        // 仅所有者线程调用
+        void push(T* item) {
+            std::int64_t b = bottom_.load(std::memory_order_relaxed);
+            std::int64_t t = top_.load(std::memory_order_acquire);
+            Array* a = array_.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1) {
+                a = grow(a, t, b);
+            }
+            a->put(b, item);
+            bottom_.store(b + 1, std::memory_order_seq_cst);
+        }
+
+        // 仅所有者线程调用，队列为空时返回 nullptr
+        T* pop() {
+            std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+            Array* a = array_.load(std::memory_order_relaxed);
+            bottom_.store(b, std::memory_order_seq_cst);
+            std::int64_t t = top_.load(std::memory_order_seq_cst);
+            if (t > b) {
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            T* item = a->get(b);
+            if (t == b) {
+                // 只剩最后一个元素，与窃取者竞争
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        // 任意线程调用，队列为空或竞争失败时返回 nullptr
+        T* steal() {
+            std::int64_t t = top_.load(std::memory_order_seq_cst);
+            std::int64_t b = bottom_.load(std::memory_order_seq_cst);
+            if (t >= b) return nullptr;
+            Array* a = array_.load(std::memory_order_acquire);
+            T* item = a->get(t);
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+    private:
+        Array* grow(Array* old, std::int64_t t, std::int64_t b) {
+            arrays_.emplace_back(new Array(old->capacity * 2));
+            Array* a = arrays_.back().get();
+            for (std::int64_t i = t; i < b; ++i) {
+                a->put(i, old->get(i));
+            }
+            array_.store(a, std::memory_order_release);
+            return a;
+        }
+
+        std::atomic<std::int64_t> top_{ 0 };
+        std::atomic<std::int64_t> bottom_{ 0 };
+        std::atomic<Array*> array_{ nullptr };
+        std::vector<std::unique_ptr<Array>> arrays_; // 仅所有者线程修改
+    };
+
+    // 内置的工作窃取线程池：每个工作线程拥有一个 Chase-Lev 队列，
+    // 工作线程内提交的任务压入自己的队列，外部提交的任务进入共享的注入队列
+    class WorkStealingPool {
+        struct Task {
+            std::function<void()> fn;
+        };
+
+        struct Worker {
+            ChaseLevDeque<Task> deque;
+            std::thread thread;
+        };
+
+    public:
+        explicit WorkStealingPool(unsigned threads = 0) {
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            for (unsigned i = 0; i < threads; ++i) {
+                workers_.emplace_back(new Worker());
+            }
+            for (unsigned i = 0; i < threads; ++i) {
+                workers_[i]->thread = std::thread([this, i]() { workerLoop(i); });
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // 执行完所有已提交的任务后再退出
+        ~WorkStealingPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& worker : workers_) {
+                worker->thread.join();
+            }
+        }
+
+        unsigned size() const {
+            return static_cast<unsigned>(workers_.size());
+        }
+
+        void execute(std::function<void()> fn) {
+            Task* task = new Task{ std::move(fn) };
+            queued_.fetch_add(1, std::memory_order_seq_cst);
+            if (currentPool() == this) {
+                workers_[currentIndex()]->deque.push(task);
+            } else {
+                std::lock_guard<std::mutex> lock(mutex_);
+                injected_.push_back(task);
+            }
+            if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                wake_.notify_one();
+            }
+        }
+
+    private:
+        static WorkStealingPool*& currentPool() {
+            static thread_local WorkStealingPool* pool = nullptr;
+            return pool;
+        }
+
+        static std::size_t& currentIndex() {
+            static thread_local std::size_t index = 0;
+            return index;
+        }
+
+        Task* findTask(std::size_t self) {
+            if (Task* task = workers_[self]->deque.pop()) return task;
+            for (std::size_t k = 1; k < workers_.size(); ++k) {
+                if (Task* task = workers_[(self + k) % workers_.size()]->deque.steal()) return task;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (injected_.empty()) return nullptr;
+            Task* task = injected_.front();
+            injected_.pop_front();
+            return task;
+        }
+
+        void workerLoop(std::size_t self) {
+            currentPool() = this;
+            currentIndex() = self;
+            while (true) {
+                if (Task* task = findTask(self)) {
+                    queued_.fetch_sub(1, std::memory_order_seq_cst);
+                    task->fn();
+                    delete task;
+                    continue;
+                }
+
+                // 没有可执行的任务时休眠，queued_ 与 sleeping_ 的顺序一致性保证不会丢失唤醒
+                std::unique_lock<std::mutex> lock(mutex_);
+                sleeping_.fetch_add(1, std::memory_order_seq_cst);
+                while (queued_.load(std::memory_order_seq_cst) <= 0 && !stop_) {
+                    wake_.wait(lock);
+                }
+                sleeping_.fetch_sub(1, std::memory_order_seq_cst);
+                if (stop_ && queued_.load(std::memory_order_seq_cst) <= 0) return;
+            }
+        }
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::deque<Task*> injected_;
+        bool stop_ = false;
+        std::atomic<std::ptrdiff_t> queued_{ 0 };  // 已提交但尚未取出的任务数
+        std::atomic<int> sleeping_{ 0 };
+    };
+
+    // 任务图中的节点：全部前驱完成后执行 work；work 中派生的子节点全部完成后节点才算完成
+    struct TaskNode {
+        std::function<void(TaskNode*)> work;
+        std::atomic<int> dependencies{ 0 };   // 尚未完成的前驱数
+        std::atomic<int> outstanding{ 1 };    // 自身的 work 加上尚未完成的子节点数
+        TaskNode* owner = nullptr;
+        std::vector<TaskNode*> successors;    // 只在节点可能被执行前修改
+    };
+
+    // 在任意执行器上运行的任务图（DAG），执行器只需提供 execute(std::function<void()>)
+    // 不能在同一执行器的任务内部等待，否则可能死锁
+    template <typename Executor>
+    class TaskGraph {
+    public:
+        explicit TaskGraph(Executor& executor) : executor_(executor) {}
+
+        // 创建节点；指定 owner 时，owner 在该节点完成前不会完成
+        TaskNode* create(std::function<void(TaskNode*)> work, TaskNode* owner = nullptr) {
+            std::lock_guard<std::mutex> lock(nodesMutex_);
+            nodes_.emplace_back();
+            TaskNode* node = &nodes_.back();
+            node->work = std::move(work);
+            node->owner = owner;
+            if (owner) owner->outstanding.fetch_add(1, std::memory_order_relaxed);
+            live_.fetch_add(1, std::memory_order_relaxed);
+            return node;
+        }
+
+        // before 完成后 after 才能开始
+        void precede(TaskNode* before, TaskNode* after) {
+            before->successors.push_back(after);
+            after->dependencies.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 提交没有未完成前驱的节点
+        void launch(TaskNode* node) {
+            if (node->dependencies.load(std::memory_order_acquire) == 0) submit(node);
+        }
+
+        // 等待所有节点完成，重新抛出任务中的第一个异常
+        void wait() {
+            std::unique_lock<std::mutex> lock(doneMutex_);
+            done_.wait(lock, [this]() { return live_.load(std::memory_order_acquire) == 0; });
+            if (error_) std::rethrow_exception(error_);
+        }
+
+    private:
+        void submit(TaskNode* node) {
+            executor_.execute([this, node]() { run(node); });
+        }
+
+        void run(TaskNode* node) {
+            if (!failed_.load(std::memory_order_relaxed)) {
+                try {
+                    node->work(node);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(doneMutex_);
+                    if (!error_) error_ = std::current_exception();
+                    failed_.store(true, std::memory_order_relaxed);
+                }
+            }
+            node->work = nullptr; // 尽早释放捕获的状态（例如合并缓冲区）
+            finish(node);
+        }
+
+        void finish(TaskNode* node) {
+            if (node->outstanding.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            for (TaskNode* next : node->successors) {
+                if (next->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) submit(next);
+            }
+            if (node->owner) finish(node->owner);
+            // 在锁内递减，保证 wait() 返回（随后析构本图）时已不再访问任何成员
+            std::lock_guard<std::mutex> lock(doneMutex_);
+            if (live_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                done_.notify_all();
+            }
+        }
+
+        Executor& executor_;
+        std::mutex nodesMutex_;
+        std::deque<TaskNode> nodes_;
+        std::atomic<std::ptrdiff_t> live_{ 0 };
+        std::atomic<bool> failed_{ false };
+        std::mutex doneMutex_;
+        std::condition_variable done_;
+        std::exception_ptr error_;
+    };
+
+    // 判断类型是否提供 execute(std::function<void()>)，用于区分重载
+    template <typename E, typename = void>
+    struct IsExecutor : std::false_type {};
+
+    template <typename E>
+    struct IsExecutor<E, std::void_t<decltype(std::declval<E&>().execute(std::function<void()>()))>>
+        : std::true_type {};
+
+    // 分块边界落在自然运行中间时，把边界后移到该运行结束处（最多到 limit），
+    // 使运行完整地留在同一块内
+    template <typename RandomIt, typename Compare>
+    std::ptrdiff_t extendChunkBoundary(RandomIt first, std::ptrdiff_t b, std::ptrdiff_t limit, Compare comp) {
+        if (b >= limit) return limit;
+        return findRunEnd(first, b, limit, comp(*(first + b), *(first + b - 1)), comp);
+    }
+
+    // 归并路径（co-rank）划分：返回合并结果的前 k 个元素中来自 a 的个数，其余 k - i 个来自 b
+    // 相等元素 a 在前，保证稳定
+    template <typename Iter, typename Compare>
+    std::ptrdiff_t coRank(std::ptrdiff_t k, Iter a, std::ptrdiff_t lenA, Iter b, std::ptrdiff_t lenB, Compare comp) {
+        std::ptrdiff_t lo = std::max<std::ptrdiff_t>(0, k - lenB);
+        std::ptrdiff_t hi = std::min(k, lenA);
+        while (lo < hi) {
+            std::ptrdiff_t i = lo + (hi - lo) / 2;
+            std::ptrdiff_t j = k - i;
+            if (j > 0 && i < lenA && !comp(b[j - 1], a[i])) {
+                // a[i] 不大于 b[j - 1]，应排在其前面，需要取更多 a
+                lo = i + 1;
+            } else {
+                hi = i;
+            }
+        }
+        return lo;
+    }
+
+    // 将不相交的有序区间 [a, aEnd) 与 [b, bEnd) 合并移动到 dest
+    template <typename Iter, typename OutIt, typename Compare>
+    void mergeMoveForward(Iter a, Iter aEnd, Iter b, Iter bEnd, OutIt dest, Compare comp) {
+        while (a != aEnd && b != bEnd) {
+            if (comp(*b, *a)) {
+                *dest++ = std::move(*b++);
+            } else {
+                *dest++ = std::move(*a++);
+            }
+        }
+        dest = std::move(a, aEnd, dest);
+        std::move(b, bEnd, dest);
+    }
+
+    // 并行合并的共享缓冲区：移动任务把 [start, start + n) 分 parts 段移入 scratch，合并阶段再写回。
+    // 兄弟任务抛出异常时任务图会跳过尚未开始的节点，合并阶段可能不运行；此时析构函数把已移入的段
+    // 移回原位并析构，原区间不会留下被移走的值，缓冲区中的元素也不会泄漏
+    template <typename RandomIt, typename T>
+    class ParallelMergeScratch {
+    public:
+        ParallelMergeScratch(RandomIt start, std::ptrdiff_t n, std::ptrdiff_t parts)
+            : start_(start), n_(n), parts_(parts), moved_(static_cast<std::size_t>(parts), 0) {
+            scratch_ = buffer_.prepare(n);
+        }
+        ParallelMergeScratch(const ParallelMergeScratch&) = delete;
+        ParallelMergeScratch& operator=(const ParallelMergeScratch&) = delete;
+
+        ~ParallelMergeScratch() {
+            if (merging_) return; // 已提交给缓冲区，由其析构
+            for (std::ptrdiff_t p = 0; p < parts_; ++p) {
+                if (!moved_[p]) continue;
+                T* first = scratch_ + segmentBegin(p);
+                T* last = scratch_ + segmentBegin(p + 1);
+                // 只依赖不抛异常的移动构造（调度并行合并的前提），不要求移动赋值也不抛异常
+                std::destroy(start_ + segmentBegin(p), start_ + segmentBegin(p + 1));
+                std::uninitialized_move(first, last, start_ + segmentBegin(p));
+                std::destroy(first, last);
+            }
+        }
+
+        T* data() const { return scratch_; }
+
+        // 第 p 段移入缓冲区；各段互不重叠，可由不同线程同时调用
+        void moveIn(std::ptrdiff_t p) {
+            std::uninitialized_move(start_ + segmentBegin(p), start_ + segmentBegin(p + 1), scratch_ + segmentBegin(p));
+            moved_[p] = 1;
+        }
+
+        // 所有段均已移入，开始合并；此后缓冲区中的元素由 MergeBuffer 负责析构
+        void commit() {
+            merging_ = true;
+            buffer_.commit(n_);
+        }
+
+    private:
+        std::ptrdiff_t segmentBegin(std::ptrdiff_t p) const { return n_ * p / parts_; }
+
+        MergeBuffer<T> buffer_;
+        T* scratch_ = nullptr;
+        RandomIt start_;
+        std::ptrdiff_t n_;
+        std::ptrdiff_t parts_;
+        std::vector<char> moved_; // 每段一个标志，各移动任务只写自己的一项
+        bool merging_ = false;
+    };
+
+    // 在任务图中安排一次合并：较短的合并直接串行完成；较长的合并先把两个运行分段并行移入缓冲区，
+    // 再按归并路径把输出均分为 parts 段并行合并，每段写入互不重叠的输出区间
+    template <typename RandomIt, typename Compare, typename Graph>
+    void scheduleMerge(Graph& graph, TaskNode* self, RandomIt start, RandomIt mid, RandomIt end, Compare comp,
+                       std::ptrdiff_t parts) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        if (start == mid || mid == end) return;
+
+        // 先裁剪掉已在最终位置的元素
+        start += gallopRight(*mid, start, mid - start, 0, comp);
+        if (start == mid) return;
+        end = mid + gallopLeft(*(mid - 1), mid, end - mid, (end - mid) - 1, comp);
+        if (end == mid) return;
+
+        std::ptrdiff_t n = end - start;
+        parts = std::min(parts, n / (PARALLEL_MIN_MERGE / 4));
+        if (parts <= 1 || n < PARALLEL_MIN_MERGE || !std::is_nothrow_move_constructible<T>::value) {
+            MergeBuffer<T> buffer;
+            int minGallop = MIN_GALLOP;
+            mergeRuns(start, mid, end, comp, buffer, minGallop, PTRDIFF_MAX);
+            return;
+        }
+
+        // 缓冲区由各阶段的任务共享，最后一个引用释放时析构
+        auto buffer = std::make_shared<ParallelMergeScratch<RandomIt, T>>(start, n, parts);
+        T* scratch = buffer->data();
+        std::ptrdiff_t lenA = mid - start;
+
+        TaskNode* mergePhase = graph.create([=, &graph](TaskNode* phase) {
+            T* a = scratch;
+            T* b = scratch + lenA;
+            std::ptrdiff_t lenB = n - lenA;
+            // 分割点在启动各段之前全部算好：各段会把元素移出 scratch，
+            // 若在段内求 coRank，二分查找可能比较到其他段已移走的元素
+            std::vector<std::ptrdiff_t> splits(static_cast<std::size_t>(parts) + 1);
+            for (std::ptrdiff_t p = 0; p <= parts; ++p) {
+                splits[p] = coRank(n * p / parts, a, lenA, b, lenB, comp);
+            }
+            buffer->commit();
+            for (std::ptrdiff_t p = 0; p < parts; ++p) {
+                std::ptrdiff_t k0 = n * p / parts;
+                std::ptrdiff_t k1 = n * (p + 1) / parts;
+                std::ptrdiff_t i0 = splits[p];
+                std::ptrdiff_t i1 = splits[p + 1];
+                graph.launch(graph.create([=](TaskNode*) {
+                    mergeMoveForward(a + i0, a + i1, b + (k0 - i0), b + (k1 - i1), start + k0, comp);
+                    (void)buffer;
+                }, phase));
+            }
+        }, self);
+
+        std::vector<TaskNode*> moves;
+        for (std::ptrdiff_t p = 0; p < parts; ++p) {
+            TaskNode* move = graph.create([=](TaskNode*) { buffer->moveIn(p); }, self);
+            graph.precede(move, mergePhase);
+            moves.push_back(move);
+        }
+        for (TaskNode* move : moves) {
+            graph.launch(move);
+        }
+    }
+
+    // 并行排序，以任务图的形式在执行器上运行：
+    // 边界调整任务 -> 各块的运行检测与插入排序（局部 timsort）-> 平衡合并树中的合并任务
+    // 块数多于并行度，由工作窃取平衡各任务耗时不均的情况
+    template <typename Policy, typename RandomIt, typename Compare, typename Executor>
+    void parallelTimsortImpl(RandomIt first, RandomIt last, Compare comp, Executor& executor, unsigned parallelism) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        std::ptrdiff_t n = std::distance(first, last);
+        std::ptrdiff_t chunks = std::min<std::ptrdiff_t>(std::ptrdiff_t(4) * parallelism, n / PARALLEL_MIN_CHUNK);
+        if (parallelism <= 1 || chunks <= 1) {
+            SortContext<T> ctx;
+            timsortImpl<Policy>(first, last, comp, ctx);
+            return;
+        }
+
+        // 按长度均分，再由边界任务调整每个边界避免切断自然运行
+        std::vector<std::ptrdiff_t> nominal(chunks + 1);
+        for (std::ptrdiff_t i = 0; i <= chunks; ++i) {
+            nominal[i] = n * i / chunks;
+        }
+        std::vector<std::ptrdiff_t> bounds = nominal;
+
+        TaskGraph<Executor> graph(executor);
+        std::vector<TaskNode*> boundaryTasks(chunks + 1, nullptr);
+        for (std::ptrdiff_t i = 1; i < chunks; ++i) {
+            boundaryTasks[i] = graph.create([&, i](TaskNode*) {
+                bounds[i] = extendChunkBoundary(first, nominal[i], nominal[i + 1], comp);
+            });
+        }
+
+        // 递归构建平衡合并树，返回表示块 [lo, hi) 排序完成的节点
+        std::function<TaskNode*(std::ptrdiff_t, std::ptrdiff_t)> build = [&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+            if (hi - lo == 1) {
+                TaskNode* leaf = graph.create([&, lo](TaskNode*) {
+                    SortContext<T> ctx;
+                    timsortImpl<Policy>(first + bounds[lo], first + bounds[lo + 1], comp, ctx);
+                });
+                // 块可能延伸到下一个名义边界，而边界 lo + 2 会读取该处之前的一个元素
+                for (std::ptrdiff_t b = lo; b <= std::min(lo + 2, chunks); ++b) {
+                    if (boundaryTasks[b]) graph.precede(boundaryTasks[b], leaf);
+                }
+                return leaf;
+            }
+            std::ptrdiff_t mid = lo + (hi - lo) / 2;
+            TaskNode* left = build(lo, mid);
+            TaskNode* right = build(mid, hi);
+            // 合并越靠近树根，可拆分的段数越多
+            std::ptrdiff_t parts = std::max<std::ptrdiff_t>(1, parallelism * (hi - lo) / chunks);
+            TaskNode* merge = graph.create([&, lo, mid, hi, parts](TaskNode* self) {
+                scheduleMerge(graph, self, first + bounds[lo], first + bounds[mid], first + bounds[hi], comp, parts);
+            });
+            graph.precede(left, merge);
+            graph.precede(right, merge);
+            return merge;
+        };
+        build(0, chunks);
+
+        for (std::ptrdiff_t i = 1; i < chunks; ++i) {
+            graph.launch(boundaryTasks[i]);
+        }
+        graph.wait();
+    }
+
+    // 按键排序的方式：每次比较时调用投影，或先提取键再排序（装饰），automatic 按元素与键的大小选择
+    enum class KeyMode {
+        automatic,
+        project,
+        decorate
+    };
+
+    // 装饰排序中的紧凑条目：提取出的键与元素的原始下标
+    template <typename Key, typename Index>
+    struct DecoratedKey {
+        Key key;
+        Index index;
+    };
+
+    // applyPermutation 用下标的最高位作标记，Index 类型的排列最多能重排的元素个数
+    template <typename Index>
+    constexpr std::size_t maxPermutationLength() {
+        return static_cast<std::size_t>(std::numeric_limits<Index>::max() / 2) + 1;
+    }
+
+    // 按排列 order 原地重排若干列：排序后每列位置 i 的元素为该列原来的第 order[i] 个元素
+    // 沿置换环移动，每个元素只移动一次，额外每列只需一个临时元素；多列共用一次遍历，order 只标记与恢复一次
+    // 处理过的位置把下标按位取反作为标记（取反后不小于 n），结束时恢复，因此 order 的最高位必须空闲
+    template <typename IndexIt, typename... RandomIts>
+    void permuteColumns(IndexIt order, std::size_t n, RandomIts... columns) {
+        using Index = typename std::iterator_traits<IndexIt>::value_type;
+        static_assert(std::is_unsigned<Index>::value, "permutation indices must be unsigned integers");
+        assert(n <= maxPermutationLength<Index>());
+
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t j = i;
+            if (static_cast<std::size_t>(order[i]) == i || static_cast<std::size_t>(order[i]) >= n) continue;
+            auto tmp = std::make_tuple(std::move(columns[i])...);
+            while (true) {
+                std::size_t next = static_cast<std::size_t>(order[j]);
+                order[j] = static_cast<Index>(~order[j]);
+                if (next == i) break;
+                ((columns[j] = std::move(columns[next])), ...);
+                j = next;
+            }
+            std::forward_as_tuple(columns[j]...) = std::move(tmp);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            if (static_cast<std::size_t>(order[i]) >= n) order[i] = static_cast<Index>(~order[i]);
+        }
+    }
+
+    // 按排列 order 原地重排：排序后位置 i 的元素为原来的 first[order[i]]
+    template <typename RandomIt, typename IndexIt>
+    void applyPermutation(RandomIt first, IndexIt order, std::size_t n) {
+        permuteColumns(order, n, first);
+    }
+
+    // 装饰排序：把键与下标提取到紧凑数组中排序，再按得到的排列移动一次元素
+    // 合并只移动小条目，大元素只在最后被移动一次；timsort 稳定，相等键保持原有顺序
+    template <typename Policy, typename Index, typename RandomIt, typename Projection, typename Compare>
+    void decoratedSort(RandomIt first, std::size_t n, Projection& proj, Compare& comp) {
+        using Key = typename std::decay<decltype(std::invoke(proj, *first))>::type;
+        using Entry = DecoratedKey<Key, Index>;
+        std::vector<Entry> entries;
+        entries.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            entries.push_back(Entry{ std::invoke(proj, first[i]), static_cast<Index>(i) });
+        }
+
+        SortContext<Entry> ctx;
+        timsortImpl<Policy>(entries.begin(), entries.end(),
+                            [&comp](const Entry& a, const Entry& b) { return comp(a.key, b.key); }, ctx);
+
+        // 重排前释放键，只保留下标
+        std::vector<Index> order(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            order[i] = entries[i].index;
+        }
+        std::vector<Entry>().swap(entries);
+        applyPermutation(first, order.begin(), n);
+    }
+
+    // 间接排序中的下标：比较时经由下标读取元素
+    template <typename Index>
+    struct IndirectIndex {
+        Index value;
+    };
+
+    // 间接比较要先按下标取数，无分支合并会让下一次取数的地址依赖上一次比较的结果，
+    // 随机数据上形成一串缓存未命中；分支版本可以推测执行后续取数，因此不使用无分支合并
+    template <typename Index>
+    struct BranchlessMerge<IndirectIndex<Index>> : std::false_type {};
+
+    // 对下标 [0, n) 运行 timsort，比较下标所指的元素；初始为恒等排列，稳定性使相等元素按下标升序
+    // 按 Sorted 类型排序，再转换为 Index 输出
+    template <typename Policy, typename Sorted, typename Index, typename RandomIt, typename Compare>
+    std::vector<Index> sortedIndices(RandomIt first, std::size_t n, Compare& comp) {
+        using Entry = IndirectIndex<Sorted>;
+        std::vector<Entry> entries(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            entries[i].value = static_cast<Sorted>(i);
+        }
+        SortContext<Entry> ctx;
+        timsortImpl<Policy>(entries.begin(), entries.end(),
+                            [first, &comp](Entry a, Entry b) { return comp(first[a.value], first[b.value]); }, ctx);
+
+        std::vector<Index> order(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            order[i] = static_cast<Index>(entries[i].value);
+        }
+        return order;
+    }
+
+    template <typename Policy, typename Index, typename RandomIt, typename Compare>
+    std::vector<Index> timsortIndices(RandomIt first, RandomIt last, Compare& comp) {
+        static_assert(std::is_unsigned<Index>::value, "permutation indices must be unsigned integers");
+        std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+        if constexpr (sizeof(Index) > sizeof(std::uint32_t)) {
+            // n 允许时用 32 位下标排序，合并时移动的字节减半
+            if (n <= UINT32_MAX) {
+                return sortedIndices<Policy, std::uint32_t, Index>(first, n, comp);
+            }
+        }
+        // 结果要能交给 apply_permutation，超出范围时截断的下标会在发布构建中静默破坏数据
+        if (n > maxPermutationLength<Index>()) {
+            throw std::length_error("timsort_indices: index type too narrow for the range");
+        }
+        return sortedIndices<Policy, Index, Index>(first, n, comp);
+    }
+
+    // 列存储（SoA）的 timsort：按键列比较，所有列同步移动
+    // 运行检测、插入排序与合并只比较键列，每个决定以整段移动的形式作用到每一列上，
+    // 每列有自己的合并缓冲区，不构造元组，也不使用代理迭代器
+    template <typename Compare, typename KeyIt, typename... PayloadIts>
+    class ZipSorter {
+        using Key = typename std::iterator_traits<KeyIt>::value_type;
+        using Indices = std::index_sequence_for<KeyIt, PayloadIts...>;
+
+    public:
+        ZipSorter(Compare comp, KeyIt keys, PayloadIts... payloads) : comp_(comp), columns_(keys, payloads...) {
+            order_.reserve(MIN_MERGE);
+        }
+
+        template <typename Policy>
+        void sort(std::ptrdiff_t n) {
+            if (n <= 1) return;
+            KeyIt keys = std::get<0>(columns_);
+            std::ptrdiff_t minRun = minRunLength(n);
+            std::vector<Run> runStack;
+            runStack.reserve(MAX_MERGE_PENDING);
+
+            auto mergeAt = [&](int i) {
+                Run& run1 = runStack[i];
+                const Run& run2 = runStack[i + 1];
+                merge(run1.start, run2.start, run2.start + run2.length);
+                run1.length += run2.length;
+                runStack.erase(runStack.begin() + i + 1);
+            };
+
+            std::ptrdiff_t start = 0;
+            while (start < n) {
+                // 只在键列上检测运行，降序运行在所有列上反转
+                std::ptrdiff_t runLen = 1;
+                if (n - start > 1) {
+                    bool descending = comp_(*(keys + start + 1), *(keys + start));
+                    runLen = findRunEnd(keys + start, 2, n - start, descending, comp_);
+                    if (descending) {
+                        forEachColumn([&](auto column) { std::reverse(column + start, column + start + runLen); });
+                    }
+                }
+                if (runLen < minRun) {
+                    std::ptrdiff_t force = std::min(minRun, n - start);
+                    insertionSort(start, start + runLen, start + force);
+                    runLen = force;
+                }
+                Policy::pushRun(runStack, Run{ start, runLen, 0 }, n, mergeAt);
+                start += runLen;
+            }
+            while (runStack.size() > 1) {
+                mergeAt(static_cast<int>(runStack.size()) - 2);
+            }
+        }
+
+    private:
+        template <typename F>
+        void forEachColumn(F f) {
+            forEachColumn(f, Indices());
+        }
+
+        template <typename F, std::size_t... I>
+        void forEachColumn(F& f, std::index_sequence<I...>) {
+            (f(std::get<I>(columns_)), ...);
+        }
+
+        // 将各列的 [lo, hi) 移入各自的缓冲区，返回各缓冲区的起始指针
+        template <std::size_t... I>
+        auto moveIn(std::ptrdiff_t lo, std::ptrdiff_t hi, std::index_sequence<I...>) {
+            return std::make_tuple(std::get<I>(buffers_).moveIn(std::get<I>(columns_) + lo, std::get<I>(columns_) + hi)...);
+        }
+
+        // 各列的 [src, src + count) 移到 [dest, dest + count)，要求 dest <= src
+        void moveForward(std::ptrdiff_t src, std::ptrdiff_t count, std::ptrdiff_t dest) {
+            forEachColumn([&](auto column) { std::move(column + src, column + src + count, column + dest); });
+        }
+
+        // 各列的 [src, src + count) 移到以 destEnd 结尾的位置，要求 destEnd >= src + count
+        void moveBackward(std::ptrdiff_t src, std::ptrdiff_t count, std::ptrdiff_t destEnd) {
+            forEachColumn([&](auto column) { std::move_backward(column + src, column + src + count, column + destEnd); });
+        }
+
+        // 各列缓冲区中的 [src, src + count) 移回列中的 dest
+        template <typename Buffers, std::size_t... I>
+        void moveOut(Buffers& buffers, std::ptrdiff_t src, std::ptrdiff_t count, std::ptrdiff_t dest,
+                     std::index_sequence<I...>) {
+            (std::move(std::get<I>(buffers) + src, std::get<I>(buffers) + src + count, std::get<I>(columns_) + dest), ...);
+        }
+
+        template <std::size_t... I>
+        void clearBuffers(std::index_sequence<I...>) {
+            (std::get<I>(buffers_).clear(), ...);
+        }
+
+        // 各列缓冲区中的第 src 个元素移到列中的 dest
+        template <typename Buffers, std::size_t... I>
+        void moveOneOut(Buffers& buffers, std::ptrdiff_t src, std::ptrdiff_t dest, std::index_sequence<I...>) {
+            ((*(std::get<I>(columns_) + dest) = std::move(std::get<I>(buffers)[src])), ...);
+        }
+
+        // 各列的第 src 个元素移到 dest
+        void moveOne(std::ptrdiff_t src, std::ptrdiff_t dest) {
+            forEachColumn([&](auto column) { *(column + dest) = std::move(*(column + src)); });
+        }
+
+        // 二分插入排序：[lo, sorted) 已有序。只在块内的下标数组上插入，
+        // 最后每列按排列沿置换环移动一次，避免每次插入都在所有列上整段平移
+        void insertionSort(std::ptrdiff_t lo, std::ptrdiff_t sorted, std::ptrdiff_t hi) {
+            KeyIt keys = std::get<0>(columns_) + lo;
+            std::ptrdiff_t n = hi - lo;
+            order_.resize(static_cast<std::size_t>(n));
+            for (std::ptrdiff_t i = 0; i < n; ++i) {
+                order_[i] = static_cast<std::uint32_t>(i);
+            }
+            auto byKey = [&](std::uint32_t a, std::uint32_t b) { return comp_(*(keys + a), *(keys + b)); };
+            binaryInsertionSort(order_.begin(), order_.begin() + (sorted - lo), order_.end(), byKey);
+            forEachColumn([&](auto column) { applyPermutation(column + lo, order_.begin(), static_cast<std::size_t>(n)); });
+        }
+
+        // 与 mergeRuns 相同，先用跳跃搜索裁去已在最终位置的前后缀，再从较短一侧开始合并
+        void merge(std::ptrdiff_t start, std::ptrdiff_t mid, std::ptrdiff_t end) {
+            KeyIt keys = std::get<0>(columns_);
+            start += gallopRight(*(keys + mid), keys + start, mid - start, 0, comp_);
+            if (start == mid) return;
+            end = mid + gallopLeft(*(keys + mid - 1), keys + mid, end - mid, (end - mid) - 1, comp_);
+            if (end == mid) return;
+            if (mid - start <= end - mid) {
+                mergeLo(start, mid, end);
+            } else {
+                mergeHi(start, mid, end);
+            }
+        }
+
+        // 缓冲左侧运行，从前向后合并，结构与 timsort_detail::mergeLo 相同：
+        // 逐个比较直到一侧连续胜出 minGallop_ 次，再进入跳跃模式整段移动各列
+        void mergeLo(std::ptrdiff_t start, std::ptrdiff_t mid, std::ptrdiff_t end) {
+            KeyIt keys = std::get<0>(columns_);
+            auto left = moveIn(start, mid, Indices());
+            const Key* leftKeys = std::get<0>(left);
+            std::ptrdiff_t leftLen = mid - start;
+            std::ptrdiff_t i = 0;   // 缓冲区中左侧的下一个元素
+            std::ptrdiff_t j = mid; // 右侧的下一个元素
+            std::ptrdiff_t dest = start;
+
+            while (i < leftLen && j < end) {
+                std::ptrdiff_t count1 = 0; // 左侧连续胜出次数
+                std::ptrdiff_t count2 = 0; // 右侧连续胜出次数
+                do {
+                    if (comp_(*(keys + j), leftKeys[i])) {
+                        moveOne(j++, dest++);
+                        ++count2;
+                        count1 = 0;
+                    } else {
+                        moveOneOut(left, i++, dest++, Indices());
+                        ++count1;
+                        count2 = 0;
+                    }
+                } while (i < leftLen && j < end && (count1 | count2) < minGallop_);
+                if (i == leftLen || j == end) break;
+
+                ++minGallop_;
+                do {
+                    minGallop_ -= minGallop_ > 1;
+
+                    // 左侧不大于 keys[j] 的元素
+                    count1 = gallopRight(*(keys + j), leftKeys + i, leftLen - i, 0, comp_);
+                    moveOut(left, i, count1, dest, Indices());
+                    i += count1;
+                    dest += count1;
+                    if (i == leftLen) break;
+
+                    // 右侧严格小于 leftKeys[i] 的元素
+                    count2 = gallopLeft(leftKeys[i], keys + j, end - j, 0, comp_);
+                    moveForward(j, count2, dest);
+                    j += count2;
+                    dest += count2;
+                    if (j == end) break;
+                } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+                if (i == leftLen || j == end) break;
+                ++minGallop_;
+            }
+            // 右侧剩余部分已在原位
+            moveOut(left, i, leftLen - i, dest, Indices());
+            clearBuffers(Indices());
+        }
+
+        // 缓冲右侧运行，从后向前合并，为 mergeLo 的镜像
+        void mergeHi(std::ptrdiff_t start, std::ptrdiff_t mid, std::ptrdiff_t end) {
+            KeyIt keys = std::get<0>(columns_);
+            auto right = moveIn(mid, end, Indices());
+            const Key* rightKeys = std::get<0>(right);
+            std::ptrdiff_t i = end - mid; // 缓冲区中右侧未合并部分为 [0, i)
+            std::ptrdiff_t j = mid;       // 左侧未合并部分为 [start, j)
+            std::ptrdiff_t dest = end;
+
+            while (i > 0 && j > start) {
+                std::ptrdiff_t count1 = 0; // 左侧连续胜出次数
+                std::ptrdiff_t count2 = 0; // 右侧连续胜出次数
+                do {
+                    if (comp_(rightKeys[i - 1], *(keys + j - 1))) {
+                        moveOne(--j, --dest);
+                        ++count1;
+                        count2 = 0;
+                    } else {
+                        moveOneOut(right, --i, --dest, Indices());
+                        ++count2;
+                        count1 = 0;
+                    }
+                } while (i > 0 && j > start && (count1 | count2) < minGallop_);
+                if (i == 0 || j == start) break;
+
+                ++minGallop_;
+                do {
+                    minGallop_ -= minGallop_ > 1;
+
+                    // 左侧严格大于 rightKeys[i - 1] 的元素
+                    std::ptrdiff_t leftLen = j - start;
+                    count1 = leftLen - gallopRight(rightKeys[i - 1], keys + start, leftLen, leftLen - 1, comp_);
+                    moveBackward(j - count1, count1, dest);
+                    j -= count1;
+                    dest -= count1;
+                    if (j == start) break;
+
+                    // 右侧不小于 keys[j - 1] 的元素
+                    count2 = i - gallopLeft(*(keys + j - 1), rightKeys, i, i - 1, comp_);
+                    moveOut(right, i - count2, count2, dest - count2, Indices());
+                    i -= count2;
+                    dest -= count2;
+                    if (i == 0) break;
+                } while (count1 >= MIN_GALLOP || count2 >= MIN_GALLOP);
+                if (i == 0 || j == start) break;
+                ++minGallop_;
+            }
+            // 左侧剩余部分已在原位
+            moveOut(right, 0, i, dest - i, Indices());
+            clearBuffers(Indices());
+        }
+
+        Compare comp_;
+        int minGallop_ = MIN_GALLOP;
+        std::vector<std::uint32_t> order_; // 插入排序块内的排列
+        std::tuple<KeyIt, PayloadIts...> columns_;
+        std::tuple<MergeBuffer<typename std::iterator_traits<KeyIt>::value_type>,
+                   MergeBuffer<typename std::iterator_traits<PayloadIts>::value_type>...> buffers_;
+    };
+
+    // 判断类型是否为可用 std::begin 与 std::size 访问的范围
+    template <typename R, typename = void>
+    struct IsSizedRange : std::false_type {};
+
+    template <typename R>
+    struct IsSizedRange<R, std::void_t<decltype(std::begin(std::declval<R&>())), decltype(std::size(std::declval<R&>()))>>
+        : std::true_type {};
+
+    // 判断 Compare 能否比较 Keys 范围中的元素
+    template <typename Compare, typename Keys, typename = void>
+    struct IsKeyComparator : std::false_type {};
+
+    template <typename Compare, typename Keys>
+    struct IsKeyComparator<Compare, Keys, std::void_t<decltype(*std::begin(std::declval<Keys&>()))>>
+        : std::is_invocable<Compare&, decltype(*std::begin(std::declval<Keys&>())),
+                            decltype(*std::begin(std::declval<Keys&>()))> {};
+
+    // 按键列排序下标，再按得到的排列一次遍历原地重排所有列
+    template <typename Policy, typename Index, typename Compare, typename Keys, typename... Payloads>
+    void timsortZipIndirect(Compare& comp, std::ptrdiff_t n, Keys& keys, Payloads&... payloads) {
+        std::vector<Index> order = sortedIndices<Policy, Index, Index>(std::begin(keys), static_cast<std::size_t>(n), comp);
+        permuteColumns(order.begin(), static_cast<std::size_t>(n), std::begin(keys), std::begin(payloads)...);
+    }
+
+    template <typename Policy, typename Compare, typename Keys, typename... Payloads>
+    void timsortZip(Compare comp, Keys& keys, Payloads&... payloads) {
+        std::ptrdiff_t n = static_cast<std::ptrdiff_t>(std::size(keys));
+        // 较短的列会在合并中越界读写，必须在移动任何元素之前检查
+        if (!((static_cast<std::ptrdiff_t>(std::size(payloads)) == n) && ...)) {
+            throw std::invalid_argument("timsort_zip: payload columns must have the same length as keys");
+        }
+        // 键列有较长的自然运行时（例如近乎有序的时间序列），合并的跳跃模式要在每列上逐段移动，
+        // 不如只对下标排序，再按排列把每列原地重排一次；接近随机时逐列同步合并更快
+        if (n >= MIN_MERGE && !lacksRuns(std::begin(keys), n, comp)) {
+            if (static_cast<std::size_t>(n) <= maxPermutationLength<std::uint32_t>()) {
+                timsortZipIndirect<Policy, std::uint32_t>(comp, n, keys, payloads...);
+            } else {
+                timsortZipIndirect<Policy, std::size_t>(comp, n, keys, payloads...);
+            }
+            return;
+        }
+        ZipSorter<Compare, decltype(std::begin(keys)), decltype(std::begin(payloads))...> sorter(
+            comp, std::begin(keys), std::begin(payloads)...);
+        sorter.template sort<Policy>(n);
+    }
+
+    // 字符串排序的条目：缓存前 8 个字节（大端，不足补 0）以整数比较，并直接保存字符数据的地址与长度，
+    // 需要比较字符时不必先访问字符串对象；lcp 为与所在运行中前一个条目的最长公共前缀长度，
+    // 合并时用来跳过已知相同的前缀；index 为字符串原来的位置
+    struct StringEntry {
+        std::uint64_t prefix;
+        const char* data;
+        std::uint32_t size;
+        std::uint32_t lcp;
+        std::uint32_t index;
+    };
+
+    // std::string 与 std::string_view 的逐字节比较与 char_traits<char>::compare 一致，可以使用字符串专用路径
+    template <typename T>
+    struct IsByteString : std::false_type {};
+
+    template <typename Alloc>
+    struct IsByteString<std::basic_string<char, std::char_traits<char>, Alloc>> : std::true_type {};
+
+    template <>
+    struct IsByteString<std::string_view> : std::true_type {};
+
+    // timsort 能否改用字符串专用路径：连续存储的字节字符串，比较器为 std::less
+    template <typename RandomIt, typename Compare>
+    struct StringSort {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        static constexpr bool enabled = IsByteString<T>::value && IsContiguousIterator<RandomIt, T>::value &&
+                                        (std::is_same<Compare, std::less<T>>::value ||
+                                         std::is_same<Compare, std::less<>>::value);
+    };
+
+    // 字符串专用的 timsort：先把每个字符串的前缀与地址提取到紧凑条目中排序，再按排列移动一次字符串
+    // 前缀不同时只比较整数，不访问字符串内容；合并使用 LCP 合并（Ng 与 Kakehi），
+    // 由两侧与上一个输出元素的公共前缀长度直接决定顺序，需要比较字符时也从已知公共前缀之后开始
+    template <typename String>
+    class StringSorter {
+        using Entry = StringEntry;
+
+    public:
+        // 比较 a 与 b，已知两者（跳过共同前缀后）前 from 个字节相同；返回符号（负数表示 a < b）并通过 lcp 返回公共前缀长度
+        static int compareFrom(const Entry& a, const Entry& b, std::uint32_t from, std::uint32_t& lcp) {
+            if (from < 8 && a.prefix != b.prefix) {
+                // 前缀中第一个不同的字节：若一侧已结束，补位的 0 小于另一侧的非零字节，顺序同样正确；
+                // 但补位的 0 可能与另一侧真实的 0 字节相同，公共前缀不超过较短一侧的有效字节数
+                std::uint64_t diff = a.prefix ^ b.prefix;
+                std::uint32_t same = 0;
+                while (!(diff & (std::uint64_t(0xff) << (56 - 8 * same)))) ++same;
+                lcp = std::min(same, std::min(std::min(a.size, b.size), 8u));
+                return a.prefix < b.prefix ? -1 : 1;
+            }
+            const char* x = a.data;
+            const char* y = b.data;
+            std::uint32_t n = std::min(a.size, b.size);
+            std::uint32_t i = from < 8 ? std::min(8u, n) : from;
+            // 每次比较 8 个字节，找到不同的块后再逐字节定位
+            while (i + 8 <= n) {
+                std::uint64_t u, v;
+                std::memcpy(&u, x + i, 8);
+                std::memcpy(&v, y + i, 8);
+                if (u != v) break;
+                i += 8;
+            }
+            while (i < n && x[i] == y[i]) ++i;
+            lcp = i;
+            if (i < n) {
+                return static_cast<unsigned char>(x[i]) < static_cast<unsigned char>(y[i]) ? -1 : 1;
+            }
+            return a.size < b.size ? -1 : (a.size > b.size ? 1 : 0);
+        }
+
+        static bool less(const Entry& a, const Entry& b) {
+            std::uint32_t lcp;
+            return compareFrom(a, b, 0, lcp) < 0;
+        }
+
+        // 元素个数超过 2^31（排列的最高位用作标记）或字符串长度超过 32 位时无法用条目记录，
+        // 输入已大致有序或缓存的前缀不能区分字符串时不划算；这些情况返回 false，由调用方改用通用路径。
+        // 两项抽样检查只访问少量字符串，放在逐个扫描所有字符串之前，退回通用路径时几乎没有额外开销
+        template <typename Policy, typename RandomIt>
+        bool sort(RandomIt first, std::ptrdiff_t n) {
+            if (static_cast<std::size_t>(n) > INT32_MAX) return false;
+            if (mostlyPresorted(first, n) || !prefixesDiscriminate(first, n)) return false;
+            // 所有字符串共同的前缀（例如 URL 的协议与域名、日志的日期）不影响顺序，
+            // 缓存的前缀从其后开始取，否则前缀全部相同，每次比较都要访问字符串
+            const String& head = first[0];
+            std::size_t common = head.size();
+            for (std::ptrdiff_t i = 0; i < n; ++i) {
+                const String& str = first[i];
+                if (str.size() > UINT32_MAX) return false;
+                std::size_t k = 0;
+                std::size_t limit = std::min(common, str.size());
+                while (k < limit && str[k] == head[k]) ++k;
+                common = k;
+            }
+
+            entries_.resize(static_cast<std::size_t>(n));
+            for (std::ptrdiff_t i = 0; i < n; ++i) {
+                const char* data = first[i].data() + common;
+                std::uint32_t size = static_cast<std::uint32_t>(first[i].size() - common);
+                entries_[i] = Entry{ loadPrefix(data, size), data, size, 0, static_cast<std::uint32_t>(i) };
+            }
+
+            sortEntries<Policy>(n);
+
+            std::vector<std::uint32_t> order(static_cast<std::size_t>(n));
+            for (std::ptrdiff_t i = 0; i < n; ++i) {
+                order[i] = entries_[i].index;
+            }
+            applyPermutation(first, order.begin(), static_cast<std::size_t>(n));
+            return true;
+        }
+
+    private:
+        static std::uint64_t loadPrefix(const char* data, std::uint32_t size) {
+            std::uint64_t prefix = 0;
+            for (std::uint32_t k = 0; k < 8; ++k) {
+                prefix = (prefix << 8) | (k < size ? static_cast<unsigned char>(data[k]) : 0u);
+            }
+            return prefix;
+        }
+
+        // 抽样判断输入是否已大致有序（升序或降序）：比较相隔一定距离的若干对元素，逆序的比例很低或很高时
+        // timsort 的运行检测与插入排序几乎不移动元素，通用路径已经很快，提取条目与按排列移动字符串得不偿失。
+        // 随机输入约有一半的对逆序；只在局部抖动的输入（例如大致按时间排列的日志键）相隔较远的对仍然有序
+        template <typename RandomIt>
+        static bool mostlyPresorted(RandomIt first, std::ptrdiff_t n) {
+            if (n < STRING_ORDER_SAMPLES * STRING_ORDER_DISTANCE) return false;
+            int inverted = 0;
+            for (int s = 0; s < STRING_ORDER_SAMPLES; ++s) {
+                RandomIt sample = first + n / STRING_ORDER_SAMPLES * s;
+                inverted += *(sample + STRING_ORDER_DISTANCE) < *sample;
+            }
+            return inverted * 8 <= STRING_ORDER_SAMPLES || inverted * 8 >= STRING_ORDER_SAMPLES * 7;
+        }
+
+        // 抽样判断缓存的前缀能否区分字符串。前缀大多相同时（例如只有少数几个主机名的 URL），
+        // 合并后期几乎每次比较仍要访问字符串，提取条目与按排列移动字符串的开销得不偿失。
+        // 此时尚未扫描所有字符串，公共前缀只按样本计算
+        template <typename RandomIt>
+        static bool prefixesDiscriminate(RandomIt first, std::ptrdiff_t n) {
+            if (n < STRING_PREFIX_SAMPLES) return true;
+            const String& head = first[0];
+            std::size_t common = head.size();
+            for (int s = 1; s < STRING_PREFIX_SAMPLES; ++s) {
+                const String& str = first[n / STRING_PREFIX_SAMPLES * s];
+                std::size_t k = 0;
+                std::size_t limit = std::min(common, str.size());
+                while (k < limit && str[k] == head[k]) ++k;
+                common = k;
+            }
+            std::uint64_t samples[STRING_PREFIX_SAMPLES];
+            for (int s = 0; s < STRING_PREFIX_SAMPLES; ++s) {
+                const String& str = first[n / STRING_PREFIX_SAMPLES * s];
+                samples[s] = loadPrefix(str.data() + common, static_cast<std::uint32_t>(str.size() - common));
+            }
+            std::sort(samples, samples + STRING_PREFIX_SAMPLES);
+            int repeated = 0;
+            for (int s = 1; s < STRING_PREFIX_SAMPLES; ++s) {
+                repeated += samples[s] == samples[s - 1];
+            }
+            return repeated * 4 <= STRING_PREFIX_SAMPLES;
+        }
+
+        template <typename Policy>
+        void sortEntries(std::ptrdiff_t n) {
+            Entry* e = entries_.data();
+            std::ptrdiff_t minRun = minRunLength(n);
+            std::vector<Run> runStack;
+            runStack.reserve(MAX_MERGE_PENDING);
+            auto less = [](const Entry& a, const Entry& b) { return StringSorter::less(a, b); };
+
+            auto mergeAt = [&](int i) {
+                Run& run1 = runStack[i];
+                const Run& run2 = runStack[i + 1];
+                merge(run1.start, run2.start, run2.start + run2.length);
+                run1.length += run2.length;
+                runStack.erase(runStack.begin() + i + 1);
+            };
+
+            std::ptrdiff_t start = 0;
+            while (start < n) {
+                // 检测运行时顺便记录相邻元素的公共前缀长度
+                std::ptrdiff_t runLen = 1;
+                if (n - start > 1) {
+                    std::uint32_t lcp;
+                    bool descending = compareFrom(e[start + 1], e[start], 0, lcp) < 0;
+                    e[start + 1].lcp = lcp;
+                    runLen = 2;
+                    while (start + runLen < n) {
+                        bool smaller = compareFrom(e[start + runLen], e[start + runLen - 1], 0, lcp) < 0;
+                        if (smaller != descending) break;
+                        e[start + runLen].lcp = lcp;
+                        ++runLen;
+                    }
+                    if (descending) {
+                        // 反转后每个条目记录的公共前缀属于其后一个位置
+                        std::reverse(e + start, e + start + runLen);
+                        for (std::ptrdiff_t k = runLen - 1; k > 0; --k) {
+                            e[start + k].lcp = e[start + k - 1].lcp;
+                        }
+                    }
+                }
+                if (runLen < minRun) {
+                    std::ptrdiff_t force = std::min(minRun, n - start);
+                    binaryInsertionSort(e + start, e + start + runLen, e + start + force, less);
+                    // 插入改变了相邻关系，重新计算整块的公共前缀
+                    for (std::ptrdiff_t k = 1; k < force; ++k) {
+                        compareFrom(e[start + k - 1], e[start + k], 0, e[start + k].lcp);
+                    }
+                    runLen = force;
+                }
+                e[start].lcp = 0;
+                Policy::pushRun(runStack, Run{ start, runLen, 0 }, n, mergeAt);
+                start += runLen;
+            }
+            while (runStack.size() > 1) {
+                mergeAt(static_cast<int>(runStack.size()) - 2);
+            }
+        }
+
+        // LCP 合并：设 x 为上一个输出元素，ha、hb 分别为 x 与两侧当前元素的公共前缀长度。
+        // ha > hb 时左侧更小，ha < hb 时右侧更小，只有相等时才需要从 ha 开始比较字符
+        void merge(std::ptrdiff_t start, std::ptrdiff_t mid, std::ptrdiff_t end) {
+            Entry* e = entries_.data();
+            auto less = [](const Entry& a, const Entry& b) { return StringSorter::less(a, b); };
+            std::ptrdiff_t runStart = start;
+            // 与 mergeRuns 相同，先裁去已在最终位置的前后缀
+            start += gallopRight(e[mid], e + start, mid - start, 0, less);
+            if (start == mid) {
+                // 两个运行已经有序，右侧第一个元素的前驱变为左侧最后一个元素
+                compareFrom(e[mid - 1], e[mid], 0, e[mid].lcp);
+                return;
+            }
+            std::ptrdiff_t runEnd = end;
+            end = mid + gallopLeft(e[mid - 1], e + mid, end - mid, (end - mid) - 1, less);
+            if (end < runEnd) {
+                // 合并后 end 之前是左侧最后一个元素
+                compareFrom(e[mid - 1], e[end], 0, e[end].lcp);
+            }
+
+            buffer_.assign(e + start, e + mid);
+            const Entry* a = buffer_.data();
+            const Entry* aEnd = a + buffer_.size();
+            std::ptrdiff_t b = mid;
+            std::ptrdiff_t dest = start;
+
+            std::uint32_t ha;
+            std::uint32_t hb;
+            if (start == runStart) {
+                // 没有上一个输出元素，先直接比较两侧的第一个元素
+                std::uint32_t lcp;
+                if (compareFrom(e[b], *a, 0, lcp) < 0) {
+                    e[dest] = e[b++];
+                    e[dest++].lcp = 0;
+                    ha = lcp;
+                    hb = b < end ? e[b].lcp : 0;
+                } else {
+                    e[dest] = *a++;
+                    e[dest++].lcp = 0;
+                    hb = lcp;
+                    ha = a < aEnd ? a->lcp : 0;
+                }
+            } else {
+                ha = a->lcp;
+                compareFrom(e[start - 1], e[b], 0, hb);
+            }
+
+            while (a < aEnd && b < end) {
+                if (ha > hb) {
+                    e[dest] = *a++;
+                    e[dest++].lcp = ha;
+                    ha = a < aEnd ? a->lcp : 0;
+                } else if (ha < hb) {
+                    e[dest] = e[b++];
+                    e[dest++].lcp = hb;
+                    hb = b < end ? e[b].lcp : 0;
+                } else {
+                    std::uint32_t lcp;
+                    if (compareFrom(e[b], *a, ha, lcp) < 0) {
+                        e[dest] = e[b++];
+                        e[dest++].lcp = hb;
+                        ha = lcp;
+                        hb = b < end ? e[b].lcp : 0;
+                    } else {
+                        e[dest] = *a++;
+                        e[dest++].lcp = ha;
+                        hb = lcp;
+                        ha = a < aEnd ? a->lcp : 0;
+                    }
+                }
+            }
+            if (a < aEnd) {
+                std::ptrdiff_t rest = aEnd - a;
+                std::copy(a, aEnd, e + dest);
+                e[dest].lcp = ha;
+                dest += rest;
+            } else if (b < end) {
+                // 右侧剩余部分已在原位，只需更新第一个元素与新前驱的公共前缀
+                e[b].lcp = hb;
+            }
+            buffer_.clear();
+        }
+
+        std::vector<Entry> entries_;
+        std::vector<Entry> buffer_;
+    };
+
+    template <typename Policy, typename RandomIt, typename Compare>
+    void timsortStrings(RandomIt first, RandomIt last, Compare comp) {
+        using String = typename std::iterator_traits<RandomIt>::value_type;
+        std::ptrdiff_t n = std::distance(first, last);
+        if (n <= 1) return;
+        StringSorter<String> sorter;
+        if (!sorter.template sort<Policy>(first, n)) {
+            SortContext<String> ctx;
+            timsortImpl<Policy>(first, last, comp, ctx);
+        }
+    }
+
+    // 基数排序的键：把算术值映射为按无符号整数比较时顺序与 std::less 相同的位模式
+    template <typename T, typename = void>
+    struct RadixKey {
+        static constexpr bool enabled = false;
+    };
+
+    template <typename T>
+    struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                                               (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+        static constexpr bool enabled = true;
+        using Bits = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+
+        static Bits get(T value) {
+            Bits bits = static_cast<Bits>(value);
+            // 有符号整数翻转符号位，负数排在非负数之前
+            if constexpr (std::is_signed<T>::value) bits ^= Bits(1) << (sizeof(T) * 8 - 1);
+            return bits;
+        }
+    };
+
+    template <typename T>
+    struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559 &&
+                                               (sizeof(T) == 4 || sizeof(T) == 8)>::type> {
+        static constexpr bool enabled = true;
+        using Bits = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+
+        static Bits get(T value) {
+            // std::less 不对 NaN 定序，统一映射为最大的键排在最后；-0.0 与 0.0 相等，映射为同一个键以保持稳定
+            if (value != value) return ~Bits(0);
+            if (value == T(0)) value = T(0);
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            // 负数翻转全部位（绝对值越大越小），非负数只置上符号位
+            const Bits sign = Bits(1) << (sizeof(T) * 8 - 1);
+            return (bits & sign) ? ~bits : bits | sign;
+        }
+    };
+
+    // timsort 能否在输入接近随机时改用基数排序：连续存储的 32/64 位整数或浮点数，比较器为 std::less 或 std::greater
+    template <typename RandomIt, typename Compare>
+    struct RadixSort {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        static constexpr bool less = std::is_same<Compare, std::less<T>>::value ||
+                                     std::is_same<Compare, std::less<>>::value;
+        static constexpr bool greater = std::is_same<Compare, std::greater<T>>::value ||
+                                        std::is_same<Compare, std::greater<>>::value;
+        static constexpr bool enabled = RadixKey<T>::enabled && IsContiguousIterator<RandomIt, T>::value && (less || greater);
+    };
+
+    // 稳定的 LSD 基数排序，每趟按键的一个字节分配；先一次统计所有字节的直方图，
+    // 所有元素该字节都相同的趟直接跳过（例如取值范围较小的 64 位整数只需少数几趟）
+    template <bool Descending, int DigitBits, typename RandomIt>
+    void radixSort(RandomIt first, std::ptrdiff_t n) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        using Key = RadixKey<T>;
+        using Bits = typename Key::Bits;
+        constexpr int Passes = (sizeof(Bits) * 8 + DigitBits - 1) / DigitBits;
+        constexpr int Buckets = 1 << DigitBits;
+        auto digits = [](const T& value) { return Descending ? ~Key::get(value) : Key::get(value); };
+        auto digit = [](Bits bits, int d) { return static_cast<std::size_t>((bits >> (DigitBits * d)) & (Buckets - 1)); };
+
+        std::vector<std::size_t> counts(Passes * Buckets);
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            Bits bits = digits(first[i]);
+            for (int d = 0; d < Passes; ++d) {
+                ++counts[d * Buckets + digit(bits, d)];
+            }
+        }
+
+        std::unique_ptr<T[]> buffer(new T[static_cast<std::size_t>(n)]);
+        T* src = &*first;
+        T* dst = buffer.get();
+        for (int d = 0; d < Passes; ++d) {
+            std::size_t* count = &counts[d * Buckets];
+            if (count[digit(digits(src[0]), d)] == static_cast<std::size_t>(n)) continue;
+            // 计数转换为各桶的起始位置
+            std::size_t offset = 0;
+            for (int b = 0; b < Buckets; ++b) {
+                std::size_t c = count[b];
+                count[b] = offset;
+                offset += c;
+            }
+            for (std::ptrdiff_t i = 0; i < n; ++i) {
+                dst[count[digit(digits(src[i]), d)]++] = src[i];
+            }
+            std::swap(src, dst);
+        }
+        if (src != &*first) {
+            std::copy(src, src + n, &*first);
+        }
+    }
+
+    template <typename Policy, typename RandomIt, typename Compare>
+    void timsortRadix(RandomIt first, RandomIt last, Compare comp) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        std::ptrdiff_t n = std::distance(first, last);
+        if (n >= RADIX_MIN_LENGTH && lacksRuns(first, n, comp)) {
+            constexpr bool descending = RadixSort<RandomIt, Compare>::greater;
+            if (n >= RADIX_WIDE_DIGIT_LENGTH) {
+                radixSort<descending, 11>(first, n);
+            } else {
+                radixSort<descending, 8>(first, n);
+            }
+        } else {
+            SortContext<T> ctx;
+            timsortImpl<Policy>(first, last, comp, ctx);
+        }
+    }
+
+    template <typename Policy, typename RandomIt, typename Projection, typename Compare>
+    void timsortByKey(RandomIt first, RandomIt last, Projection& proj, Compare& comp, KeyMode mode) {
+        using T = typename std::iterator_traits<RandomIt>::value_type;
+        using Key = typename std::decay<decltype(std::invoke(proj, *first))>::type;
+        std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+
+        if (mode == KeyMode::automatic) {
+            // 元素远大于装饰条目且键可以廉价复制时，装饰排序减少的数据移动才能抵消提取与重排的开销
+            bool decorate = std::is_trivially_copyable<Key>::value && n > static_cast<std::size_t>(MIN_MERGE) &&
+                            sizeof(T) >= 4 * sizeof(DecoratedKey<Key, std::uint32_t>);
+            mode = decorate ? KeyMode::decorate : KeyMode::project;
+        }
+
+        if (mode == KeyMode::project || n < 2) {
+            SortContext<T> ctx;
+            timsortImpl<Policy>(first, last, [&](const T& a, const T& b) {
+                return comp(std::invoke(proj, a), std::invoke(proj, b));
+            }, ctx);
+        } else if (n <= maxPermutationLength<std::uint32_t>()) {
+            // 下标尽量用 32 位，条目更小，合并时移动的字节更少；重排时最高位用作标记，因此只到 2^31
+            decoratedSort<Policy, std::uint32_t>(first, n, proj, comp);
+        } else {
+            decoratedSort<Policy, std::size_t>(first, n, proj, comp);
+        }
+    }
+
+} // namespace timsort_detail
+
+// 可选的合并策略
+using timsort_classic_policy = timsort_detail::ClassicMergePolicy;
+using timsort_powersort_policy = timsort_detail::PowersortMergePolicy;
+
+// 单次排序的选项，例如 timsort_options{ .max_scratch_bytes = 64 << 20 }
+using timsort_options = timsort_detail::SortOptions;
+
+// 可在多次调用之间复用的排序上下文，保留合并缓冲区与运行堆栈；
+// 也可由调用方提供 n / 2 * sizeof(T) 字节的缓冲区（std::span<std::byte>），排序时不再进行堆分配
+template <typename T, typename Alloc = std::allocator<T>>
+using timsort_context = timsort_detail::SortContext<T, Alloc>;
+
+// 对外接口，简化使用
+// 合并策略可通过首个模板参数指定，例如 timsort<timsort_powersort_policy>(first, last, comp)
+// 只有这个重载会按元素类型改用字符串或基数排序专用路径，合并策略只作用于合并引擎；
+// 需要始终使用合并引擎时（例如比较合并策略），使用带 timsort_context 或 timsort_options 的重载
+template <typename Policy = timsort_classic_policy, typename RandomIt,
+          typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
+void timsort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    // 按默认顺序排序 std::string / std::string_view 时使用缓存前缀与 LCP 合并的专用路径
+    if constexpr (timsort_detail::StringSort<RandomIt, Compare>::enabled) {
+        timsort_detail::timsortStrings<Policy>(first, last, comp);
+    } else if constexpr (timsort_detail::RadixSort<RandomIt, Compare>::enabled) {
+        // 32/64 位整数与浮点数在抽样发现没有可利用的运行时改用稳定的基数排序，有序程度较高的输入仍走 timsort
+        timsort_detail::timsortRadix<Policy>(first, last, comp);
+    } else {
+        timsort_context<typename std::iterator_traits<RandomIt>::value_type> ctx;
+        timsort_detail::timsortImpl<Policy>(first, last, comp, ctx);
+    }
+}
+
+// 复用上下文的重载，适合频繁排序大量中小规模数据的场景；始终使用合并引擎
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Compare, typename T, typename Alloc>
+void timsort(RandomIt first, RandomIt last, Compare comp, timsort_context<T, Alloc>& ctx) {
+    static_assert(std::is_same<T, typename std::iterator_traits<RandomIt>::value_type>::value,
+                  "timsort_context element type must match the iterator value type");
+    timsort_detail::timsortImpl<Policy>(first, last, comp, ctx);
+}
+
+// 带选项的重载，例如限制合并缓冲区的内存上限，超出上限的合并改为原地进行
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Compare>
+void timsort(RandomIt first, RandomIt last, Compare comp, const timsort_options& options) {
+    timsort_context<typename std::iterator_traits<RandomIt>::value_type> ctx;
+    timsort_detail::timsortImpl<Policy>(first, last, comp, ctx, options);
+}
+
+// 同时复用上下文并指定选项
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Compare, typename T, typename Alloc>
+void timsort(RandomIt first, RandomIt last, Compare comp, timsort_context<T, Alloc>& ctx, const timsort_options& options) {
+    static_assert(std::is_same<T, typename std::iterator_traits<RandomIt>::value_type>::value,
+                  "timsort_context element type must match the iterator value type");
+    timsort_detail::timsortImpl<Policy>(first, last, comp, ctx, options);
+}
+
+// 使用指定分配器分配合并缓冲区与运行堆栈
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Compare, typename Alloc,
+          typename std::enable_if<timsort_detail::IsAllocator<Alloc>::value, int>::type = 0>
+void timsort(RandomIt first, RandomIt last, Compare comp, const Alloc& alloc) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    using ElementAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+    timsort_context<T, ElementAlloc> ctx{ ElementAlloc(alloc) };
+    timsort_detail::timsortImpl<Policy>(first, last, comp, ctx);
+}
+
+// 从 memory_resource（例如 std::pmr::monotonic_buffer_resource）分配排序所需的临时内存
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Compare>
+void timsort(RandomIt first, RandomIt last, Compare comp, std::pmr::memory_resource* resource) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    timsort<Policy>(first, last, comp, std::pmr::polymorphic_allocator<T>(resource));
+}
+
+// 完全不分配内存的稳定排序，适用于无法分配内存的场景（例如共享内存段）
+// 运行检测与合并调度与 timsort 相同，合并只使用固定大小的栈上缓冲区，
+// 较长的合并通过旋转切分为能放入缓冲区的子合并
+template <typename Policy = timsort_classic_policy, typename RandomIt,
+          typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
+void timsort_inplace(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    timsort_detail::InplaceContext<T> ctx;
+    timsort_options options;
+    options.max_scratch_bytes = timsort_detail::InplaceContext<T>::BufferLength * sizeof(T);
+    timsort_detail::timsortImpl<Policy>(first, last, comp, ctx, options);
+}
+
+// timsort_by_key 的模式，见 timsort_detail::KeyMode
+using timsort_key_mode = timsort_detail::KeyMode;
+
+// 按投影得到的键排序，例如 timsort_by_key(v.begin(), v.end(), &Record::timestamp)
+// proj 可以是成员指针或任意可调用对象，键之间用 comp 比较；mode 为 decorate 时先把键提取到紧凑数组中排序，
+// 再一次性按排列移动元素，适合元素大而键小的情况，需要额外 O(n) 内存；结果与 project 模式相同且保持稳定
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Projection, typename Compare = std::less<>>
+void timsort_by_key(RandomIt first, RandomIt last, Projection proj, Compare comp = Compare(),
+                    timsort_key_mode mode = timsort_key_mode::automatic) {
+    timsort_detail::timsortByKey<Policy>(first, last, proj, comp, mode);
+}
+
+// 稳定的 argsort：返回排列 order，使 first[order[0]], first[order[1]], ... 有序，不移动原数据
+// 排序在下标数组上进行，n 不超过 2^32 时内部使用 32 位下标；可通过 Index 指定结果的下标类型，例如 std::uint32_t
+// 为了能交给 apply_permutation，n 不得超过 Index 最大值的一半加一（std::uint32_t 为 2^31），否则抛出 std::length_error
+template <typename Policy = timsort_classic_policy, typename Index = std::size_t, typename RandomIt,
+          typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
+std::vector<Index> timsort_indices(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    return timsort_detail::timsortIndices<Policy, Index>(first, last, comp);
+}
+
+// 按 timsort_indices 得到的排列原地重排 [first, last)，使位置 i 的元素为原来的 first[order[i]]
+// order 指向与区间等长的无符号下标序列，重排期间借用最高位作标记，返回前恢复原值；不分配内存
+// 区间长度超过下标类型最大值的一半加一时抛出 std::length_error
+template <typename RandomIt, typename IndexIt>
+void apply_permutation(RandomIt first, RandomIt last, IndexIt order) {
+    using Index = typename std::iterator_traits<IndexIt>::value_type;
+    std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+    if (n > timsort_detail::maxPermutationLength<Index>()) {
+        throw std::length_error("apply_permutation: index type too narrow for the range");
+    }
+    timsort_detail::applyPermutation(first, order, n);
+}
+
+// 列存储数据的排序：按 keys 排序，并把每个 payload 列同步移动到相同位置，例如
+// timsort_zip(timestamps, prices, volumes)；各列可以是 vector、数组或 span 等，长度必须相同（否则抛出 std::invalid_argument），保持稳定
+// 每列使用自己的合并缓冲区整段移动，不构造元组，合并缓冲区的总大小为各列元素大小之和乘以较短运行的长度
+template <typename Policy = timsort_classic_policy, typename Keys, typename... Payloads,
+          typename std::enable_if<timsort_detail::IsSizedRange<Keys>::value, int>::type = 0>
+void timsort_zip(Keys&& keys, Payloads&&... payloads) {
+    timsort_detail::timsortZip<Policy>(std::less<>(), keys, payloads...);
+}
+
+// 指定键比较器的 timsort_zip，例如 timsort_zip(std::greater<>(), keys, payload)
+template <typename Policy = timsort_classic_policy, typename Compare, typename Keys, typename... Payloads,
+          typename std::enable_if<timsort_detail::IsKeyComparator<Compare, Keys>::value &&
+                                  timsort_detail::IsSizedRange<Keys>::value, int>::type = 0>
+void timsort_zip(Compare comp, Keys&& keys, Payloads&&... payloads) {
+    timsort_detail::timsortZip<Policy>(comp, keys, payloads...);
+}
+
+// 内置的工作窃取线程池，也可作为 timsort_parallel 的执行器在多次排序间复用
+using timsort_thread_pool = timsort_detail::WorkStealingPool;
+
+// 并行 timsort：threads 为 0 时使用硬件线程数，保持稳定；不使用字符串或基数排序专用路径
+template <typename Policy = timsort_classic_policy, typename RandomIt,
+          typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
+void timsort_parallel(RandomIt first, RandomIt last, Compare comp = Compare(), unsigned threads = 0) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads <= 1 || std::distance(first, last) < 2 * timsort_detail::PARALLEL_MIN_CHUNK) {
+        // 与多线程路径一样只使用合并引擎，单线程与多线程的耗时可以直接比较
+        timsort_context<typename std::iterator_traits<RandomIt>::value_type> ctx;
+        timsort<Policy>(first, last, comp, ctx);
+        return;
+    }
+    timsort_thread_pool pool(threads);
+    timsort_detail::parallelTimsortImpl<Policy>(first, last, comp, pool, threads);
+}
+
+// 在调用方提供的执行器上运行并行 timsort，执行器需提供 execute(std::function<void()>)
+// parallelism 为执行器可用的并发度，用于决定分块数；不能在该执行器的任务内部调用
+template <typename Policy = timsort_classic_policy, typename RandomIt, typename Compare, typename Executor,
+          typename std::enable_if<timsort_detail::IsExecutor<Executor>::value, int>::type = 0>
+void timsort_parallel(RandomIt first, RandomIt last, Compare comp, Executor& executor, unsigned parallelism) {
+    timsort_detail::parallelTimsortImpl<Policy>(first, last, comp, executor, std::max(1u, parallelism));
+}
+
+#if defined(__cpp_lib_execution)
+// 与标准并行算法形式一致的重载，可直接替换 std::stable_sort(std::execution::par, ...)
+// par 与 par_unseq 使用并行 timsort，seq 与 unseq 退化为串行 timsort；与 timsort_parallel 一样只使用合并引擎
+template <typename Policy = timsort_classic_policy, typename ExecutionPolicy, typename RandomIt,
+          typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>,
+          typename std::enable_if<std::is_execution_policy<typename std::decay<ExecutionPolicy>::type>::value,
+                                  int>::type = 0>
+void timsort(ExecutionPolicy&&, RandomIt first, RandomIt last, Compare comp = Compare()) {
+    using Exec = typename std::decay<ExecutionPolicy>::type;
+    if constexpr (std::is_same<Exec, std::execution::parallel_policy>::value ||
+                  std::is_same<Exec, std::execution::parallel_unsequenced_policy>::value) {
+        timsort_parallel<Policy>(first, last, comp);
+    } else {
+        timsort_context<typename std::iterator_traits<RandomIt>::value_type> ctx;
+        timsort<Policy>(first, last, comp, ctx);
+    }
 }
+#endif
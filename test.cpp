@@ -1,3 +1,9 @@
+// libstdc++ 检测到 TBB 头文件时，标准并行算法默认使用 TBB 后端，需要链接 -ltbb
+// 未定义 TIMSORT_WITH_TBB 时改用串行后端，使本文件不依赖 TBB 也能编译
+#if !defined(TIMSORT_WITH_TBB) && !defined(_GLIBCXX_USE_TBB_PAR_BACKEND)
+#define _GLIBCXX_USE_TBB_PAR_BACKEND 0
+#endif
+
 #include <iostream>
 #include <vector>
 #include <algorithm>
@@ -6,6 +12,50 @@
 #include <chrono>
 #include <string>
 #include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <memory_resource>
+#include <thread>
+#include <atomic>
+#if __has_include(<execution>)
+#include <execution>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// 统计全局 operator new 的调用次数，用于验证使用内存池排序时不触发全局分配
+static std::atomic<std::size_t> globalNewCount{ 0 };
+
+// 替换的 operator new/delete 用 malloc/free 实现；GCC 把它们内联到调用处后会误报 new 与 free 不匹配
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    ++globalNewCount;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
 
 template <typename RandomIt, typename Compare>
 void quickSort(RandomIt first, RandomIt last, Compare comp) {
@@ -25,175 +75,1063 @@ void quickSort(RandomIt first, RandomIt last, Compare comp) {
 }
 
 
-namespace timsort_detail {
+#include "mian.cpp"
 
-    const int MIN_MERGE = 32;
+// 在稀疏映射的超过 2^31 个元素的数组上验证 64 位长度与偏移
+// 数组主体全为 0（读取时映射到零页，不占用物理内存），只在末尾写入一段随机数据，
+// 使合并发生在 2^31 之后的偏移上
+static void testHugeSparseArray() {
+#if defined(__linux__) && PTRDIFF_MAX > 0x7fffffff
+    const std::size_t n = (std::size_t(1) << 31) + (std::size_t(1) << 20);
+    const std::size_t tailSize = 100000;
 
-    static int minRunLength(int n) {
-        int r = 0;
-        while (n >= MIN_MERGE) {
-            r |= (n & 1);
-            n >>= 1;
-        }
-        return n + r;
-    }
-
-    template <typename RandomIt, typename Compare>
-    static void binaryInsertionSort(RandomIt left, RandomIt right, Compare comp) {
-        for (auto it = left + 1; it < right; ++it) {
-            auto key = std::move(*it);
-     
-            RandomIt pos = std::upper_bound(left, it, key, comp);
-            if (pos != it) {
-                std::move_backward(pos, it, it + 1);
-                *pos = std::move(key);
-            }
+    void* mem = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        std::cout << "Huge sparse array test skipped: mmap failed" << std::endl;
+        return;
+    }
+    unsigned char* data = static_cast<unsigned char*>(mem);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 9);
+    std::size_t counts[10] = {};
+    counts[0] = n - tailSize;
+    for (std::size_t i = n - tailSize; i < n; ++i) {
+        data[i] = static_cast<unsigned char>(dist(gen));
+        ++counts[data[i]];
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    timsort(data, data + n);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // 排序后应为各值的连续区段
+    std::size_t pos = 0;
+    for (int v = 0; v < 10; ++v) {
+        for (std::size_t i = 0; i < counts[v]; i += 4096) {
+            assert(data[pos + i] == v);
         }
+        assert(counts[v] == 0 || data[pos + counts[v] - 1] == v);
+        pos += counts[v];
     }
+    assert(std::is_sorted(data + n - 2 * tailSize, data + n));
+
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << "Huge sparse array (" << n << " elements) sorted in " << elapsed.count() << " ms" << std::endl;
+    munmap(mem, n);
+#else
+    std::cout << "Huge sparse array test skipped: requires 64-bit Linux" << std::endl;
+#endif
+}
+
+// 不可默认构造的元素类型，验证合并缓冲区不依赖默认构造并保持稳定
+struct Record {
+    Record() = delete;
+    Record(int key, int seq) : key(key), seq(seq), payload(std::to_string(seq)) {}
+    int key;
+    int seq;
+    std::string payload;
+};
 
+static void testNonDefaultConstructible() {
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> dist(0, 99);
+    std::vector<Record> records;
+    for (int i = 0; i < 20000; ++i) {
+        records.emplace_back(dist(gen), i);
+    }
+    timsort(records.begin(), records.end(), [](const Record& a, const Record& b) { return a.key < b.key; });
+    for (std::size_t i = 1; i < records.size(); ++i) {
+        assert(records[i - 1].key < records[i].key ||
+               (records[i - 1].key == records[i].key && records[i - 1].seq < records[i].seq));
+        assert(records[i].payload == std::to_string(records[i].seq));
+    }
+    std::cout << "Non-default-constructible stable sort: passed" << std::endl;
+}
 
-    template <typename RandomIt, typename Compare>
-    static void mergeRuns(RandomIt start, RandomIt mid, RandomIt end, Compare comp, std::vector<typename std::iterator_traits<RandomIt>::value_type>& buffer) {
-        using ValueType = typename std::iterator_traits<RandomIt>::value_type;
-        int leftSize = static_cast<int>(mid - start);
-        int rightSize = static_cast<int>(end - mid);
+// 构建短块的三条路径：int32/int64 在 AVX2 可用时使用排序网络，小型可平凡复制的记录使用无分支二分插入，
+// 其余类型（这里是带 std::string 的 Record）使用成对插入。长度覆盖奇偶、minRun 附近与以有序段开头的输入，
+// 且不超过基数排序的最小长度，结果须与 std::stable_sort 一致
+struct SmallRecord {
+    int key;
+    int seq;
+};
+static_assert(timsort_detail::BranchlessInsertion<SmallRecord>::value, "SmallRecord should use branchless insertion");
+static_assert(!timsort_detail::BranchlessInsertion<Record>::value, "Record should use pair insertion");
 
-        if (buffer.size() < static_cast<size_t>(leftSize)) {
-            buffer.resize(leftSize);
+static void testSmallSortPaths() {
+    std::mt19937 gen(67);
+    auto byKey = [](const auto& a, const auto& b) { return a.key < b.key; };
+    for (int round = 0; round < 3000; ++round) {
+        int n = static_cast<int>(gen() % 200);
+        int range = 1 + static_cast<int>(gen() % (round % 2 ? 8 : 100000));
+        std::vector<int> keys(n);
+        for (auto& k : keys) {
+            k = static_cast<int>(gen() % range);
+        }
+        if (round % 3 == 0) {
+            std::sort(keys.begin(), keys.begin() + n / 3);
         }
+        std::vector<int> order(n);
+        for (int i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return keys[a] < keys[b]; });
 
-        std::move(start, mid, buffer.begin());
+        std::vector<std::int32_t> ints(keys.begin(), keys.end());
+        std::vector<std::int64_t> longs(keys.begin(), keys.end());
+        std::vector<SmallRecord> small;
+        std::vector<Record> records;
+        for (int i = 0; i < n; ++i) {
+            small.push_back(SmallRecord{ keys[i], i });
+            records.emplace_back(keys[i], i);
+        }
+        timsort(ints.begin(), ints.end(), std::less<std::int32_t>());
+        timsort(longs.begin(), longs.end(), std::less<>());
+        timsort(small.begin(), small.end(), byKey);
+        timsort(records.begin(), records.end(), byKey);
+        for (int i = 0; i < n; ++i) {
+            assert(ints[i] == keys[order[i]] && longs[i] == keys[order[i]]);
+            assert(small[i].seq == order[i]);
+            assert(records[i].seq == order[i] && records[i].payload == std::to_string(order[i]));
+        }
+    }
+    std::cout << "Small sort paths test passed" << std::endl;
+}
 
-        RandomIt left = buffer.begin();
-        RandomIt leftEnd = buffer.begin() + leftSize;
-        RandomIt right = mid;
-        RandomIt rightEnd = end;
-        RandomIt dest = start;
+// 大量中小规模向量的批量排序：每次新建状态 vs 复用 timsort_context
+static void benchmarkContextReuse() {
+    const int batchCount = 20000;
+    const int batchSize = 256;
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    std::vector<std::vector<int>> batches(batchCount, std::vector<int>(batchSize));
+    for (auto& batch : batches) {
+        for (auto& val : batch) {
+            val = dist(gen);
+        }
+    }
 
-        while (left != leftEnd && right != rightEnd) {
-            if (comp(*left, *right)) {
-                *dest++ = std::move(*left++);
-            }
-            else {
-                *dest++ = std::move(*right++);
-            }
+    auto measureBatch = [&](const std::string& name, const std::function<void(std::vector<int>&)>& sortFunc) {
+        std::vector<std::vector<int>> data = batches;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto& batch : data) {
+            sortFunc(batch);
         }
+        auto end = std::chrono::high_resolution_clock::now();
+        for (const auto& batch : data) {
+            assert(std::is_sorted(batch.begin(), batch.end()));
+        }
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        std::cout << name << ": " << elapsed.count() << " microseconds for " << batchCount << " vectors." << std::endl;
+    };
+
+    // 每次新建上下文；带上下文的重载只使用合并引擎，与下面的复用行可以直接比较
+    measureBatch("Timsort (fresh state)", [](std::vector<int>& vec) {
+        timsort_context<int> fresh;
+        timsort(vec.begin(), vec.end(), std::less<int>(), fresh);
+    });
+
+    timsort_context<int> ctx;
+    measureBatch("Timsort (reused context)", [&](std::vector<int>& vec) { timsort(vec.begin(), vec.end(), std::less<int>(), ctx); });
 
-        if (left != leftEnd) {
-            std::move(left, leftEnd, dest);
+#if __cplusplus >= 202002L
+    // 合并只缓冲较短的一侧，n / 2 个元素足够
+    alignas(int) static std::byte scratch[batchSize / 2 * sizeof(int)];
+    timsort_context<int> spanCtx{ std::span<std::byte>(scratch) };
+    measureBatch("Timsort (caller scratch)", [&](std::vector<int>& vec) { timsort(vec.begin(), vec.end(), std::less<int>(), spanCtx); });
+#endif
+}
+
+// 不同合并缓冲区上限下的吞吐量，上限为 0 时完全原地合并
+static void benchmarkScratchCap() {
+    const int dataSize = 200000;
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    std::vector<int> input(dataSize);
+    for (auto& val : input) {
+        val = dist(gen);
+    }
+
+    const std::size_t unlimited = SIZE_MAX;
+    const std::size_t caps[] = { unlimited, dataSize * sizeof(int) / 8, dataSize * sizeof(int) / 64,
+                                 dataSize * sizeof(int) / 512, 0 };
+    for (std::size_t cap : caps) {
+        std::vector<int> data = input;
+        auto start = std::chrono::high_resolution_clock::now();
+        timsort(data.begin(), data.end(), std::less<int>(), timsort_options{ cap });
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(data.begin(), data.end()));
+
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        std::cout << "Timsort (max scratch ";
+        if (cap == unlimited) {
+            std::cout << "unlimited";
+        } else {
+            std::cout << cap << " bytes";
         }
+        std::cout << "): " << elapsed.count() << " microseconds, "
+                  << dataSize / elapsed.count() << " M elements/s" << std::endl;
+    }
+}
+
+// 并行 timsort 在 1 到 N 个线程下的扩展性
+static void benchmarkParallelScaling(const std::string& name, const std::vector<int>& input) {
+    unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    double baseline = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<int> data = input;
+        auto start = std::chrono::high_resolution_clock::now();
+        timsort_parallel(data.begin(), data.end(), std::less<int>(), threads);
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(data.begin(), data.end()));
+
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        if (threads == 1) baseline = elapsed.count();
+        std::cout << name << " (" << threads << " threads): " << elapsed.count()
+                  << " microseconds, speedup " << baseline / elapsed.count() << "x" << std::endl;
+    }
+}
+
+static void benchmarkParallelScaling() {
+    const int dataSize = 2000000;
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    std::vector<int> input(dataSize);
+    for (auto& val : input) {
+        val = dist(gen);
+    }
+    benchmarkParallelScaling("Timsort parallel, random", input);
+
+    // 两个交错的有序半段：局部排序几乎无工作量，耗时集中在顶层的一次大合并
+    std::sort(input.begin(), input.begin() + dataSize / 2);
+    std::sort(input.begin() + dataSize / 2, input.end());
+    benchmarkParallelScaling("Timsort parallel, two sorted halves", input);
+
+    // 近乎有序：各块耗时差异大，依赖工作窃取平衡负载
+    std::sort(input.begin(), input.end());
+    for (int i = 0; i < dataSize / 100; ++i) {
+        std::swap(input[gen() % dataSize], input[gen() % dataSize]);
+    }
+    benchmarkParallelScaling("Timsort parallel, nearly sorted", input);
+}
+
+// 长运行数据上的运行检测：std::less 可走向量化扫描，等价的 lambda 比较器只能逐对比较
+static void benchmarkRunDetection() {
+#if defined(__AVX512F__)
+    const char* scan = "AVX-512";
+#elif defined(__AVX2__)
+    const char* scan = "AVX2";
+#else
+    const char* scan = "scalar";
+#endif
+    const int dataSize = 20000000;
+    std::vector<int> input(dataSize);
+    // 4 段升序运行和 4 段降序运行，每段 250 万个元素，值域互不重叠，合并时裁剪后几乎无工作量
+    const int runLen = dataSize / 8;
+    for (int i = 0; i < dataSize; ++i) {
+        int run = i / runLen;
+        int offset = i % runLen;
+        input[i] = run * runLen + (run % 2 == 0 ? offset : runLen - 1 - offset);
+    }
+
+    auto run = [&](const std::string& name, auto comp) {
+        std::vector<int> data = input;
+        auto start = std::chrono::high_resolution_clock::now();
+        timsort(data.begin(), data.end(), comp);
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(data.begin(), data.end()));
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        std::cout << name << ": " << elapsed.count() << " microseconds" << std::endl;
+    };
+    run(std::string("Timsort std::less (") + scan + " scan)", std::less<int>());
+    run("Timsort lambda (scalar scan)", [](int a, int b) { return a < b; });
+}
+
+// 合并吞吐量：两个随机有序半段只需一次合并，std::less 可走双调合并网络，lambda 比较器走逐元素合并
+static void benchmarkMergeKernel() {
+#if defined(__AVX512F__)
+    const char* kernel = "AVX-512 bitonic";
+#elif defined(__AVX2__)
+    const char* kernel = "AVX2 bitonic";
+#else
+    const char* kernel = "scalar";
+#endif
+    const int dataSize = 4000000;
+    std::mt19937 gen(19);
+    std::uniform_int_distribution<int> dist(0, 1000000000);
+    std::vector<int> input(dataSize);
+    for (auto& val : input) {
+        val = dist(gen);
     }
+    std::sort(input.begin(), input.begin() + dataSize / 2);
+    std::sort(input.begin() + dataSize / 2, input.end());
 
-    struct Run {
-        int start;
-        int length;
+    auto run = [&](const std::string& name, auto comp) {
+        std::vector<int> data = input;
+        auto start = std::chrono::high_resolution_clock::now();
+        timsort(data.begin(), data.end(), comp);
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(data.begin(), data.end()));
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        std::cout << name << ": " << elapsed.count() << " microseconds" << std::endl;
     };
+    run(std::string("Timsort std::less (") + kernel + " merge)", std::less<int>());
+    run("Timsort lambda (scalar merge)", [](int a, int b) { return a < b; });
+}
 
-    template <typename RandomIt, typename Compare>
-    void timsortImpl(RandomIt first, RandomIt last, Compare comp) {
-        int n = static_cast<int>(std::distance(first, last));
-        if (n <= 1) return;
-
-        int minRun = minRunLength(n);
-        std::vector<Run> runStack;
-        runStack.reserve(64); // 预分配足够的空间
-
-        std::vector<typename std::iterator_traits<RandomIt>::value_type> buffer;
-        buffer.reserve(minRun); // 预分配缓冲区
-
-        int start = 0;
-        while (start < n) {
-            int runLen = 1;
-
-            // 检测运行方向
-            if (start + 1 < n) {
-                if (comp(*(first + start + 1), *(first + start))) {
-                    // 降序运行，反转为升序
-                    while (start + runLen < n && comp(*(first + start + runLen), *(first + start + runLen - 1))) {
-                        runLen++;
-                    }
-                    std::reverse(first + start, first + start + runLen);
-                }
-                else {
-                    // 升序运行
-                    while (start + runLen < n && !comp(*(first + start + runLen), *(first + start + runLen - 1))) {
-                        runLen++;
-                    }
-                }
+// 布局相同、分别强制使用分支合并与无分支合并的包装类型，用于对比两种合并循环；
+// 两者都关闭双向合并与无分支插入，只有合并循环不同
+template <typename T>
+struct BranchyKey {
+    T key;
+    T payload;
+};
+
+template <typename T>
+struct BranchlessKey {
+    T key;
+    T payload;
+};
+
+template <typename T>
+struct DefaultKey {
+    T key;
+    T payload;
+};
+
+// 只使用单向无分支合并的包装类型，用于对比双向合并
+template <typename T>
+struct OneWayKey {
+    T key;
+    T payload;
+};
+
+template <typename T>
+struct BidirectionalKey {
+    T key;
+    T payload;
+};
+
+// BidirectionalMerge 与 BranchlessInsertion 默认跟随 BranchlessMerge，这里逐一显式指定，
+// 使每组对比只有一项不同：BranchyKey 与 BranchlessKey 只差合并循环，OneWayKey 与 BidirectionalKey 只差双向合并
+namespace timsort_detail {
+    template <typename T>
+    struct BranchlessMerge<BranchyKey<T>> : std::false_type {};
+    template <typename T>
+    struct BidirectionalMerge<BranchyKey<T>> : std::false_type {};
+    template <typename T>
+    struct BranchlessInsertion<BranchyKey<T>> : std::false_type {};
+
+    template <typename T>
+    struct BranchlessMerge<BranchlessKey<T>> : std::true_type {};
+    template <typename T>
+    struct BidirectionalMerge<BranchlessKey<T>> : std::false_type {};
+    template <typename T>
+    struct BranchlessInsertion<BranchlessKey<T>> : std::false_type {};
+
+    template <typename T>
+    struct BranchlessMerge<OneWayKey<T>> : std::true_type {};
+    template <typename T>
+    struct BidirectionalMerge<OneWayKey<T>> : std::false_type {};
+    template <typename T>
+    struct BranchlessInsertion<OneWayKey<T>> : std::false_type {};
+
+    template <typename T>
+    struct BranchlessMerge<BidirectionalKey<T>> : std::true_type {};
+    template <typename T>
+    struct BidirectionalMerge<BidirectionalKey<T>> : std::true_type {};
+    template <typename T>
+    struct BranchlessInsertion<BidirectionalKey<T>> : std::false_type {};
+}
+
+template <template <typename> class Wrapper, typename T>
+static double timeMergeLoop(const std::vector<long long>& keys) {
+    std::vector<Wrapper<T>> data(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        data[i] = { static_cast<T>(keys[i]), static_cast<T>(i) };
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    timsort(data.begin(), data.end(), [](const Wrapper<T>& a, const Wrapper<T>& b) { return a.key < b.key; });
+    auto end = std::chrono::high_resolution_clock::now();
+    assert(std::is_sorted(data.begin(), data.end(),
+                          [](const Wrapper<T>& a, const Wrapper<T>& b) { return a.key < b.key; }));
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+template <typename T>
+static void benchmarkMergeLoop(const std::string& type, const std::string& dataName, const std::vector<long long>& keys) {
+    // 两者交替运行 5 轮，各取最短时间
+    double branchy = 0;
+    double branchless = 0;
+    for (int i = 0; i < 5; ++i) {
+        double a = timeMergeLoop<BranchyKey, T>(keys);
+        double b = timeMergeLoop<BranchlessKey, T>(keys);
+        branchy = i == 0 ? a : std::min(branchy, a);
+        branchless = i == 0 ? b : std::min(branchless, b);
+    }
+    // 默认值只由 BranchlessMerge 的大小与可平凡复制条件决定，不随这里的测量结果变化
+    bool byDefault = timsort_detail::BranchlessMerge<DefaultKey<T>>::value;
+    std::cout << type << ", " << dataName << ": branchy " << branchy << " microseconds, branchless " << branchless
+              << " microseconds (BranchlessMerge default: " << (byDefault ? "branchless" : "branchy") << ")"
+              << std::endl;
+}
+
+// 分支合并与无分支合并在不同元素大小、不同数据分布上的耗时，默认选择见 timsort_detail::BranchlessMerge
+static void benchmarkBranchlessMerge() {
+    const int dataSize = 1000000;
+    std::mt19937 gen(23);
+    std::uniform_int_distribution<long long> dist(0, 1000000000);
+
+    std::vector<long long> random(dataSize);
+    for (auto& val : random) {
+        val = dist(gen);
+    }
+    std::vector<long long> nearlySorted = random;
+    std::sort(nearlySorted.begin(), nearlySorted.end());
+    for (int i = 0; i < dataSize / 100; ++i) {
+        std::swap(nearlySorted[gen() % dataSize], nearlySorted[gen() % dataSize]);
+    }
+    std::vector<long long> manyRuns = random;
+    for (int i = 0; i < dataSize; i += 1000) {
+        std::sort(manyRuns.begin() + i, manyRuns.begin() + std::min(i + 1000, dataSize));
+    }
+
+    for (const auto& [name, keys] : { std::make_pair("random", &random), std::make_pair("nearly sorted", &nearlySorted),
+                                      std::make_pair("many runs", &manyRuns) }) {
+        benchmarkMergeLoop<int>("8-byte records", name, *keys);
+        benchmarkMergeLoop<long long>("16-byte records", name, *keys);
+        benchmarkMergeLoop<double>("16-byte double records", name, *keys);
+        benchmarkMergeLoop<long double>("32-byte records", name, *keys);
+    }
+}
+
+// 单向与双向无分支合并的耗时；双向合并只用于整个合并区间不超过 BIDIRECTIONAL_MAX_BYTES 的合并
+static void benchmarkBidirectionalMerge() {
+    const int dataSize = 1000000;
+    std::mt19937 gen(29);
+    std::uniform_int_distribution<long long> dist(0, 1000000000);
+
+    std::vector<long long> random(dataSize);
+    for (auto& val : random) {
+        val = dist(gen);
+    }
+    std::vector<long long> manyRuns = random;
+    for (int i = 0; i < dataSize; i += 1000) {
+        std::sort(manyRuns.begin() + i, manyRuns.begin() + std::min(i + 1000, dataSize));
+    }
+
+    for (const auto& [name, keys] : { std::make_pair("random", &random), std::make_pair("many runs", &manyRuns) }) {
+        for (int type = 0; type < 2; ++type) {
+            // 两者交替运行 5 轮，各取最短时间
+            double oneWay = 0;
+            double bidirectional = 0;
+            for (int i = 0; i < 5; ++i) {
+                double a = type == 0 ? timeMergeLoop<OneWayKey, int>(*keys) : timeMergeLoop<OneWayKey, long long>(*keys);
+                double b = type == 0 ? timeMergeLoop<BidirectionalKey, int>(*keys)
+                                     : timeMergeLoop<BidirectionalKey, long long>(*keys);
+                oneWay = i == 0 ? a : std::min(oneWay, a);
+                bidirectional = i == 0 ? b : std::min(bidirectional, b);
             }
+            std::cout << (type == 0 ? "8-byte records, " : "16-byte records, ") << name << ": one-way " << oneWay
+                      << " microseconds, bidirectional " << bidirectional << " microseconds" << std::endl;
+        }
+    }
+}
 
-            // 如果运行长度小于最小运行长度，进行扩展
-            if (runLen < minRun) {
-                int force = std::min(minRun, n - start);
-                binaryInsertionSort(first + start, first + start + force, comp);
-                runLen = force;
+// 200 字节的记录，按 64 位时间戳排序
+struct Event {
+    long long timestamp;
+    char body[192];
+};
+
+// 比较器直接访问记录与按键排序（投影、装饰）的耗时对比
+static void benchmarkSortByKey() {
+    const int dataSize = 500000;
+    std::mt19937 gen(37);
+    std::uniform_int_distribution<long long> dist(0, 1LL << 40);
+    std::vector<Event> events(dataSize);
+    for (int i = 0; i < dataSize; ++i) {
+        events[i].timestamp = dist(gen);
+        std::memset(events[i].body, i & 0xff, sizeof(events[i].body));
+    }
+    auto byTimestamp = [](const Event& a, const Event& b) { return a.timestamp < b.timestamp; };
+
+    auto run = [&](const std::string& name, auto sorter) {
+        std::vector<Event> data = events;
+        auto start = std::chrono::high_resolution_clock::now();
+        sorter(data);
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(data.begin(), data.end(), byTimestamp));
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        std::cout << name << ": " << elapsed.count() << " microseconds" << std::endl;
+    };
+    run("Timsort comparator", [&](std::vector<Event>& v) { timsort(v.begin(), v.end(), byTimestamp); });
+    run("timsort_by_key project", [](std::vector<Event>& v) {
+        timsort_by_key(v.begin(), v.end(), &Event::timestamp, std::less<>(), timsort_key_mode::project);
+    });
+    run("timsort_by_key decorate", [](std::vector<Event>& v) {
+        timsort_by_key(v.begin(), v.end(), &Event::timestamp, std::less<>(), timsort_key_mode::decorate);
+    });
+}
+
+// argsort：构造下标数组后调用 std::stable_sort，与 timsort_indices（64 位与 32 位下标）对比
+static void benchmarkIndices() {
+    const int dataSize = 2000000;
+    std::mt19937 gen(41);
+    std::uniform_int_distribution<int> dist(0, 1000000000);
+    std::vector<int> random(dataSize);
+    for (auto& val : random) {
+        val = dist(gen);
+    }
+    std::vector<int> nearlySorted = random;
+    std::sort(nearlySorted.begin(), nearlySorted.end());
+    for (int i = 0; i < dataSize / 100; ++i) {
+        std::swap(nearlySorted[gen() % dataSize], nearlySorted[gen() % dataSize]);
+    }
+
+    for (const auto& [name, data] : { std::make_pair("random", &random), std::make_pair("nearly sorted", &nearlySorted) }) {
+        const std::vector<int>& values = *data;
+        auto time = [](auto sorter) {
+            auto start = std::chrono::high_resolution_clock::now();
+            sorter();
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration<double, std::micro>(end - start).count();
+        };
+        double stable = time([&] {
+            std::vector<std::size_t> order(values.size());
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
             }
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return values[a] < values[b]; });
+        });
+        double wide = time([&] {
+            std::vector<std::size_t> order = timsort_indices(values.begin(), values.end());
+            assert(std::is_sorted(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return values[a] < values[b]; }));
+        });
+        double narrow = time([&] {
+            std::vector<std::uint32_t> order = timsort_indices<timsort_classic_policy, std::uint32_t>(values.begin(), values.end());
+            assert(order.size() == values.size());
+        });
+        std::cout << name << ": std::stable_sort on indices " << stable << " microseconds, timsort_indices " << wide
+                  << " microseconds, timsort_indices<uint32_t> " << narrow << " microseconds" << std::endl;
+    }
+}
+
+// 列存储数据：timsort_zip 与先排序下标再逐列收集的耗时对比；近乎有序时 timsort_zip 自身也改为排序下标，
+// 再逐列原地重排
+static void benchmarkZip() {
+    const int dataSize = 2000000;
+    std::mt19937 gen(47);
+    std::uniform_int_distribution<long long> dist(0, 1LL << 40);
+    std::vector<long long> keys(dataSize);
+    std::vector<double> prices(dataSize);
+    std::vector<int> volumes(dataSize);
+    for (int i = 0; i < dataSize; ++i) {
+        keys[i] = dist(gen);
+        prices[i] = i * 0.25;
+        volumes[i] = i;
+    }
+    std::vector<long long> nearlySortedKeys = keys;
+    std::sort(nearlySortedKeys.begin(), nearlySortedKeys.end());
+    for (int i = 0; i < dataSize / 100; ++i) {
+        std::swap(nearlySortedKeys[gen() % dataSize], nearlySortedKeys[gen() % dataSize]);
+    }
 
-            // 将当前运行压入堆栈
-            runStack.push_back(Run{ start, runLen });
-
-            // 合并运行，维护 Timsort 的堆栈不变量
-            while (runStack.size() > 1) {
-                int size = static_cast<int>(runStack.size());
-                bool shouldMerge = false;
-
-                if (size >= 3) {
-                    int A = runStack[size - 3].length;
-                    int B = runStack[size - 2].length;
-                    int C = runStack[size - 1].length;
-                    if (A <= B + C) {
-                        shouldMerge = true;
-                    }
-                }
-                if (!shouldMerge && size >= 2) {
-                    int B = runStack[size - 2].length;
-                    int C = runStack[size - 1].length;
-                    if (B <= C) {
-                        shouldMerge = true;
-                    }
-                }
-
-                if (shouldMerge) {
-                    // 弹出最后两个运行进行合并
-                    Run run2 = runStack.back(); runStack.pop_back();
-                    Run run1 = runStack.back(); runStack.pop_back();
-
-                    mergeRuns(first + run1.start, first + run1.start + run1.length,
-                        first + run1.start + run1.length + run2.length, comp, buffer);
-
-                    // 将合并后的运行压入堆栈
-                    runStack.push_back(Run{ run1.start, run1.length + run2.length });
-                }
-                else {
-                    break;
-                }
+    for (const auto& [name, source] : { std::make_pair("random", &keys), std::make_pair("nearly sorted", &nearlySortedKeys) }) {
+        auto timeZip = [&]() {
+            std::vector<long long> k = *source;
+            std::vector<double> p = prices;
+            std::vector<int> v = volumes;
+            auto start = std::chrono::high_resolution_clock::now();
+            timsort_zip(k, p, v);
+            auto end = std::chrono::high_resolution_clock::now();
+            assert(std::is_sorted(k.begin(), k.end()));
+            assert((*source)[v[dataSize / 2]] == k[dataSize / 2] && p[dataSize / 2] == v[dataSize / 2] * 0.25);
+            return std::chrono::duration<double, std::micro>(end - start).count();
+        };
+        auto timeGather = [&]() {
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<std::uint32_t> order = timsort_indices<timsort_classic_policy, std::uint32_t>(source->begin(), source->end());
+            std::vector<long long> sortedKeys(dataSize);
+            std::vector<double> sortedPrices(dataSize);
+            std::vector<int> sortedVolumes(dataSize);
+            for (int i = 0; i < dataSize; ++i) {
+                sortedKeys[i] = (*source)[order[i]];
+                sortedPrices[i] = prices[order[i]];
+                sortedVolumes[i] = volumes[order[i]];
             }
+            auto end = std::chrono::high_resolution_clock::now();
+            assert(std::is_sorted(sortedKeys.begin(), sortedKeys.end()));
+            return std::chrono::duration<double, std::micro>(end - start).count();
+        };
+        // 两者交替运行 5 轮，各取最短时间
+        double zip = 0;
+        double gather = 0;
+        for (int i = 0; i < 5; ++i) {
+            double z = timeZip();
+            double g = timeGather();
+            zip = i == 0 ? z : std::min(zip, z);
+            gather = i == 0 ? g : std::min(gather, g);
+        }
+        std::cout << name << ": timsort_zip " << zip << " microseconds, indices + gather " << gather << " microseconds"
+                  << std::endl;
+    }
+}
+
+// 字符串排序：timsort 对 std::string 默认顺序使用缓存前缀与 LCP 合并，与通用路径及 std::stable_sort 对比
+static void benchmarkStrings() {
+    const int dataSize = 500000;
+    std::mt19937 gen(53);
+    std::uniform_int_distribution<int> letter(0, 25);
+    auto word = [&](int len) {
+        std::string w;
+        for (int i = 0; i < len; ++i) {
+            w += static_cast<char>('a' + letter(gen));
+        }
+        return w;
+    };
+
+    std::vector<std::string> random(dataSize);
+    for (auto& s : random) {
+        s = word(8 + gen() % 24);
+    }
+    // 共享较长前缀的 URL；只有 20 个主机名，缓存的前缀大多相同，应退回通用路径
+    std::vector<std::string> hosts;
+    for (int i = 0; i < 20; ++i) {
+        hosts.push_back("https://www." + word(6) + ".example.com/");
+    }
+    std::vector<std::string> urls(dataSize);
+    for (auto& s : urls) {
+        s = hosts[gen() % hosts.size()] + word(4) + "/" + word(3) + "?id=" + std::to_string(gen() % 100000);
+    }
+    // 时间戳开头的日志键，大部分已按时间有序；抽样发现输入大致有序，应退回通用路径
+    std::vector<std::string> logKeys(dataSize);
+    for (int i = 0; i < dataSize; ++i) {
+        logKeys[i] = "2024-06-01T12:" + std::to_string(10000000 + i + static_cast<int>(gen() % 50)) + "|" + word(4);
+    }
 
-            start += runLen;
+    for (const auto& [name, data] : { std::make_pair("random", &random), std::make_pair("urls", &urls),
+                                      std::make_pair("log keys", &logKeys) }) {
+        auto time = [&](auto sorter) {
+            std::vector<std::string> v = *data;
+            auto start = std::chrono::high_resolution_clock::now();
+            sorter(v);
+            auto end = std::chrono::high_resolution_clock::now();
+            assert(std::is_sorted(v.begin(), v.end()));
+            return std::chrono::duration<double, std::micro>(end - start).count();
+        };
+        // 三者交替运行 5 轮，各取最短时间
+        double stable = 0;
+        double generic = 0;
+        double specialized = 0;
+        for (int i = 0; i < 5; ++i) {
+            double s = time([](std::vector<std::string>& v) { std::stable_sort(v.begin(), v.end()); });
+            double g = time([](std::vector<std::string>& v) {
+                timsort(v.begin(), v.end(), [](const std::string& a, const std::string& b) { return a < b; });
+            });
+            double p = time([](std::vector<std::string>& v) { timsort(v.begin(), v.end()); });
+            stable = i == 0 ? s : std::min(stable, s);
+            generic = i == 0 ? g : std::min(generic, g);
+            specialized = i == 0 ? p : std::min(specialized, p);
         }
+        std::cout << name << ": std::stable_sort " << stable << " microseconds, generic timsort " << generic
+                  << " microseconds, string timsort " << specialized << " microseconds" << std::endl;
+    }
+}
+
+// 基数排序回退：timsort(first, last) 在抽样发现没有可利用的运行时改用基数排序，
+// 与不做分派的 timsort（复用上下文的重载）在各种分布上对比，有序程度较高的输入应仍走 timsort
+template <typename T>
+static void benchmarkRadixCase(const std::string& name, const std::vector<T>& input) {
+    auto time = [&](auto sorter) {
+        std::vector<T> v = input;
+        auto start = std::chrono::high_resolution_clock::now();
+        sorter(v);
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(v.begin(), v.end()));
+        return std::chrono::duration<double, std::micro>(end - start).count();
+    };
+    // 两者交替运行 5 轮，各取最短时间，避免先运行的一方承担冷缓存的开销
+    double adaptive = 0;
+    double plain = 0;
+    for (int i = 0; i < 5; ++i) {
+        double a = time([](std::vector<T>& v) { timsort(v.begin(), v.end()); });
+        double p = time([](std::vector<T>& v) {
+            timsort_context<T> ctx;
+            timsort(v.begin(), v.end(), std::less<T>(), ctx);
+        });
+        adaptive = i == 0 ? a : std::min(adaptive, a);
+        plain = i == 0 ? p : std::min(plain, p);
+    }
+    std::cout << name << ": adaptive " << adaptive << " microseconds, timsort only " << plain << " microseconds"
+              << std::endl;
+}
+
+static void benchmarkRadixFallback() {
+    const int dataSize = 1000000;
+    std::mt19937_64 gen(59);
+    std::vector<int> ints(dataSize);
+    std::vector<std::uint64_t> wide(dataSize);
+    std::vector<double> reals(dataSize);
+    for (int i = 0; i < dataSize; ++i) {
+        ints[i] = static_cast<int>(gen());
+        wide[i] = gen();
+        reals[i] = std::normal_distribution<double>(0.0, 1e6)(gen);
+    }
+    benchmarkRadixCase("random int32", ints);
+    benchmarkRadixCase("random uint64", wide);
+    benchmarkRadixCase("random double", reals);
+
+    std::vector<int> fewUnique(dataSize);
+    for (auto& v : fewUnique) {
+        v = static_cast<int>(gen() % 4);
+    }
+    benchmarkRadixCase("few unique int32", fewUnique);
+
+    std::vector<int> sorted(dataSize);
+    for (int i = 0; i < dataSize; ++i) {
+        sorted[i] = i;
+    }
+    benchmarkRadixCase("sorted int32", sorted);
+
+    std::vector<int> nearlySorted = sorted;
+    for (int i = 0; i < dataSize / 100; ++i) {
+        std::swap(nearlySorted[gen() % dataSize], nearlySorted[gen() % dataSize]);
+    }
+    benchmarkRadixCase("nearly sorted int32", nearlySorted);
+
+    std::vector<int> reversed(sorted.rbegin(), sorted.rend());
+    benchmarkRadixCase("reversed int32", reversed);
+
+    // 每 100 个元素一块、块内打乱，块间有序
+    std::vector<int> shuffledBlocks = sorted;
+    for (int i = 0; i < dataSize; i += 100) {
+        std::shuffle(shuffledBlocks.begin() + i, shuffledBlocks.begin() + std::min(dataSize, i + 100), gen);
+    }
+    benchmarkRadixCase("shuffled blocks int32", shuffledBlocks);
+
+    // 长度约 1000 的随机有序运行
+    std::vector<int> sortedRuns = ints;
+    for (int i = 0; i < dataSize; i += 1000) {
+        std::sort(sortedRuns.begin() + i, sortedRuns.begin() + std::min(dataSize, i + 1000));
+    }
+    benchmarkRadixCase("sorted runs int32", sortedRuns);
+
+    // 有序主体后追加一段随机数据
+    std::vector<int> randomTail = sorted;
+    for (int i = dataSize - dataSize / 20; i < dataSize; ++i) {
+        randomTail[i] = static_cast<int>(gen() % dataSize);
+    }
+    benchmarkRadixCase("random tail int32", randomTail);
+
+    std::vector<int> small(1000);
+    for (auto& v : small) {
+        v = static_cast<int>(gen());
+    }
+    benchmarkRadixCase("random int32 (1000 elements)", small);
+}
+
+// 关闭软件预取的包装类型，用于测量预取在超出缓存的大合并中的效果
+template <typename T>
+struct NoPrefetchKey {
+    T key;
+    T payload;
+};
+
+namespace timsort_detail {
+    template <typename T>
+    struct PrefetchDistance<NoPrefetchKey<T>> : std::integral_constant<std::ptrdiff_t, 0> {};
+}
+
+template <template <typename> class Wrapper>
+static double timeLargeSort(std::size_t n, std::size_t runs, unsigned seed) {
+    std::vector<Wrapper<int>> data(n);
+    std::mt19937 gen(seed);
+    for (std::size_t i = 0; i < n; ++i) {
+        data[i] = { static_cast<int>(gen() & 0x7fffffff), static_cast<int>(i) };
+    }
+    auto comp = [](const Wrapper<int>& a, const Wrapper<int>& b) { return a.key < b.key; };
+    // runs 不为 0 时先把数据分成 runs 个有序段，只测量合并阶段
+    for (std::size_t r = 0; r < runs; ++r) {
+        std::sort(data.begin() + n / runs * r, r + 1 == runs ? data.end() : data.begin() + n / runs * (r + 1), comp);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    timsort(data.begin(), data.end(), comp);
+    auto end = std::chrono::high_resolution_clock::now();
+    assert(std::is_sorted(data.begin(), data.end(), comp));
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// 1 亿个 8 字节记录，合并远超 L2 容量，比较启用与关闭软件预取的耗时
+static void benchmarkLargePrefetch() {
+    const std::size_t n = 100000000;
+    for (std::size_t runs : { std::size_t(0), std::size_t(16) }) {
+        const char* name = runs == 0 ? "random" : "16 sorted runs";
+        double without = timeLargeSort<NoPrefetchKey>(n, runs, 31);
+        double with = timeLargeSort<DefaultKey>(n, runs, 31);
+        std::cout << "100M 8-byte records, " << name << ": no prefetch " << without << " ms, prefetch " << with << " ms"
+                  << std::endl;
+    }
+}
+
+#if defined(__cpp_lib_execution)
+// 与标准库并行 stable_sort 对比；libstdc++ 使用串行后端时 std::execution::par 实际为串行执行
+static void benchmarkExecutionPolicies() {
+#if defined(_PSTL_PAR_BACKEND_TBB)
+    const char* backend = "TBB backend";
+#else
+    const char* backend = "serial backend";
+#endif
+    const int dataSize = 2000000;
+    std::mt19937 gen(17);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    std::vector<int> random(dataSize);
+    for (auto& val : random) {
+        val = dist(gen);
+    }
+    std::vector<int> nearlySorted = random;
+    std::sort(nearlySorted.begin(), nearlySorted.end());
+    for (int i = 0; i < dataSize / 100; ++i) {
+        std::swap(nearlySorted[gen() % dataSize], nearlySorted[gen() % dataSize]);
+    }
+
+    auto run = [](const std::string& name, const std::vector<int>& input, auto sorter) {
+        std::vector<int> data = input;
+        auto start = std::chrono::high_resolution_clock::now();
+        sorter(data);
+        auto end = std::chrono::high_resolution_clock::now();
+        assert(std::is_sorted(data.begin(), data.end()));
+        std::chrono::duration<double, std::micro> elapsed = end - start;
+        std::cout << name << ": " << elapsed.count() << " microseconds" << std::endl;
+    };
+
+    for (const auto& [label, input] : { std::make_pair("random", &random), std::make_pair("nearly sorted", &nearlySorted) }) {
+        std::cout << "[" << label << "]" << std::endl;
+        run(std::string("std::stable_sort(par, ") + backend + ")", *input,
+            [](std::vector<int>& v) { std::stable_sort(std::execution::par, v.begin(), v.end()); });
+        run("timsort(seq)", *input, [](std::vector<int>& v) { timsort(std::execution::seq, v.begin(), v.end()); });
+        run("timsort(par)", *input, [](std::vector<int>& v) { timsort(std::execution::par, v.begin(), v.end()); });
+        run("timsort(par_unseq)", *input,
+            [](std::vector<int>& v) { timsort(std::execution::par_unseq, v.begin(), v.end(), std::less<int>()); });
+    }
+}
+#endif
+
+// 调用方提供的执行器：复用同一个线程池，以及在调用线程上直接执行的同步执行器
+static void testParallelCustomExecutor() {
+    struct InlineExecutor {
+        void execute(std::function<void()> fn) { fn(); }
+    };
+
+    std::mt19937 gen(21);
+    std::uniform_int_distribution<int> dist(0, 999);
+    std::vector<std::pair<int, int>> input(300000);
+    for (int i = 0; i < (int)input.size(); ++i) {
+        input[i] = { dist(gen), i };
+    }
+    auto byKey = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; };
+    std::vector<std::pair<int, int>> expected = input;
+    std::stable_sort(expected.begin(), expected.end(), byKey);
+
+    timsort_thread_pool pool(4);
+    for (int round = 0; round < 3; ++round) {
+        std::vector<std::pair<int, int>> data = input;
+        timsort_parallel(data.begin(), data.end(), byKey, pool, pool.size());
+        assert(data == expected);
+    }
+
+    InlineExecutor inlineExecutor;
+    std::vector<std::pair<int, int>> data = input;
+    timsort_parallel(data.begin(), data.end(), byKey, inlineExecutor, 4);
+    assert(data == expected);
+    std::cout << "Parallel sort with custom executors: ok" << std::endl;
+}
+
+// 使用 monotonic_buffer_resource 内存池排序，验证期间没有全局 new 调用
+static void testArenaSortNoGlobalNew() {
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> dist(0, 1000000);
+    std::vector<int> data(50000);
+    for (auto& val : data) {
+        val = dist(gen);
+    }
+
+    alignas(std::max_align_t) static std::byte arena[1 << 20];
+    std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena), std::pmr::null_memory_resource());
+
+    std::size_t before = globalNewCount;
+    timsort(data.begin(), data.end(), std::less<int>(), &resource);
+    std::size_t after = globalNewCount;
+
+    assert(std::is_sorted(data.begin(), data.end()));
+    assert(after == before);
+    std::cout << "Arena sort global new calls: " << (after - before) << std::endl;
+}
+
+// 原地排序不应进行任何堆分配，且保持稳定
+static void testInplaceNoAllocation() {
+    std::mt19937 gen(9);
+    std::uniform_int_distribution<int> dist(0, 999);
+    std::vector<std::pair<int, int>> data(100000);
+    for (int i = 0; i < (int)data.size(); ++i) {
+        data[i] = { dist(gen), i };
+    }
 
-        // 最终合并所有运行
-        while (runStack.size() > 1) {
-            // 弹出最后两个运行进行合并
-            Run run2 = runStack.back(); runStack.pop_back();
-            Run run1 = runStack.back(); runStack.pop_back();
+    std::size_t before = globalNewCount;
+    timsort_inplace(data.begin(), data.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first < b.first;
+        });
+    std::size_t after = globalNewCount;
 
-            mergeRuns(first + run1.start, first + run1.start + run1.length,
-                first + run1.start + run1.length + run2.length, comp, buffer);
+    assert(std::is_sorted(data.begin(), data.end()));
+    assert(after == before);
+    std::cout << "In-place sort global new calls: " << (after - before) << std::endl;
+}
 
-            // 将合并后的运行压入堆栈
-            runStack.push_back(Run{ run1.start, run1.length + run2.length });
+#if __cplusplus >= 202002L
+// 调用方提供 n / 2 个元素的缓冲区时，包括第一次在内的多次排序都不应进行堆分配，且保持稳定
+static void testCallerScratchNoAllocation() {
+    struct Record {
+        long long key;
+        long long seq;
+    };
+    const int n = 8192;
+    const int rounds = 20;
+    std::mt19937 gen(61);
+    std::uniform_int_distribution<long long> dist(0, 999);
+    std::vector<std::vector<Record>> inputs(rounds, std::vector<Record>(n));
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < n; ++i) {
+            inputs[r][i] = { dist(gen), i };
+        }
+        // 一半输入由有序段组成，覆盖跳跃与双向合并
+        if (r % 2) {
+            for (int i = 0; i < n; i += 1000) {
+                std::stable_sort(inputs[r].begin() + i, inputs[r].begin() + std::min(i + 1000, n),
+                                 [](const Record& a, const Record& b) { return a.key < b.key; });
+            }
         }
     }
 
-} // namespace timsort_detail
+    alignas(Record) static std::byte scratch[n / 2 * sizeof(Record)];
+    timsort_context<Record> ctx{ std::span<std::byte>(scratch) };
+    auto byKey = [](const Record& a, const Record& b) { return a.key < b.key; };
+
+    std::size_t before = globalNewCount;
+    for (auto& input : inputs) {
+        timsort(input.begin(), input.end(), byKey, ctx);
+    }
+    std::size_t after = globalNewCount;
+
+    for (const auto& input : inputs) {
+        assert(std::is_sorted(input.begin(), input.end(), [](const Record& a, const Record& b) {
+            return a.key < b.key || (a.key == b.key && a.seq < b.seq);
+        }));
+    }
+    assert(after == before);
+    std::cout << "Caller scratch sort global new calls: " << (after - before) << std::endl;
+}
+#endif
+
+// timsort_indices 的结果应与稳定排序一致，apply_permutation 重排后不改变排列本身
+static void testIndicesAndPermutation() {
+    std::mt19937 gen(43);
+    std::uniform_int_distribution<int> dist(0, 99);
+    std::vector<std::pair<int, int>> data(50000);
+    for (int i = 0; i < (int)data.size(); ++i) {
+        data[i] = { dist(gen), i };
+    }
+    auto byFirst = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; };
+
+    std::vector<std::uint32_t> order = timsort_indices<timsort_classic_policy, std::uint32_t>(data.begin(), data.end(), byFirst);
+    std::vector<std::uint32_t> saved = order;
+    std::vector<std::pair<int, int>> expected = data;
+    std::stable_sort(expected.begin(), expected.end(), byFirst);
+
+    apply_permutation(data.begin(), data.end(), order.begin());
+    assert(data == expected);
+    assert(order == saved);
+
+    // 下标类型的最高位用作重排标记，8 位下标最多重排 128 个元素，超出时应报错而不是截断
+    bool threw = false;
+    try {
+        timsort_indices<timsort_classic_policy, std::uint8_t>(data.begin(), data.begin() + 129, byFirst);
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::vector<std::uint8_t> narrow = timsort_indices<timsort_classic_policy, std::uint8_t>(data.begin(), data.begin() + 128, byFirst);
+    threw = false;
+    try {
+        apply_permutation(data.begin(), data.begin() + 129, narrow.begin());
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << "Indices and permutation test passed" << std::endl;
+}
+
+// 列长度不一致时 timsort_zip 应在移动任何元素之前报错
+static void testZipLengthMismatch() {
+    std::vector<int> keys = { 3, 1, 2 };
+    std::vector<double> prices = { 30.0, 10.0 };
+    bool threw = false;
+    try {
+        timsort_zip(keys, prices);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    assert((keys == std::vector<int>{ 3, 1, 2 }));
+    assert((prices == std::vector<double>{ 30.0, 10.0 }));
+    std::cout << "Zip length mismatch test passed" << std::endl;
+}
+
+// timsort_zip 的两条路径都应稳定：接近随机的键逐列合并，有较长运行的键改为排序下标后重排各列
+static void testZipStability() {
+    const int n = 20000;
+    std::mt19937 gen(61);
+    std::vector<int> randomKeys(n);
+    for (auto& k : randomKeys) {
+        k = static_cast<int>(gen() % 500);
+    }
+    std::vector<int> runKeys(n);
+    for (int i = 0; i < n; ++i) {
+        runKeys[i] = i / 40;
+    }
+    for (int i = 0; i < n / 100; ++i) {
+        std::swap(runKeys[gen() % n], runKeys[gen() % n]);
+    }
 
-// 对外接口，简化使用
-template <typename RandomIt, typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
-void timsort(RandomIt first, RandomIt last, Compare comp = Compare()) {
-    timsort_detail::timsortImpl(first, last, comp);
+    auto check = [&](const std::vector<int>& source, auto comp) {
+        std::vector<int> keys = source;
+        std::vector<int> seq(n);
+        std::vector<std::string> labels(n);
+        for (int i = 0; i < n; ++i) {
+            seq[i] = i;
+            labels[i] = "row-" + std::to_string(i);
+        }
+        timsort_zip(comp, keys, seq, labels);
+        for (int i = 0; i < n; ++i) {
+            assert(keys[i] == source[seq[i]]);
+            assert(labels[i] == "row-" + std::to_string(seq[i]));
+            if (i > 0) {
+                assert(!comp(keys[i], keys[i - 1]));
+                assert(comp(keys[i - 1], keys[i]) || seq[i - 1] < seq[i]);
+            }
+        }
+    };
+    check(randomKeys, std::less<>());
+    check(runKeys, std::less<>());
+    check(runKeys, std::greater<>());
+    std::cout << "Zip stability test passed" << std::endl;
 }
-int main() {
+
+int main(int argc, char* argv[]) {
+    // 传入 --large 时额外运行耗时较长的大数据量测试
+    bool runLarge = argc > 1 && std::strcmp(argv[1], "--large") == 0;
+
     const int randomDataSize = 50000;
     const int specialDataSize = 1000;
     const int testIterations = 5;
@@ -207,6 +1145,8 @@ int main() {
     std::vector<int> dataNearlySorted(specialDataSize);
     std::vector<int> dataManyRuns(specialDataSize);
     std::vector<int> dataReversed(specialDataSize);
+    std::vector<int> dataAppendedTail(specialDataSize);
+    std::vector<int> dataIrregularRuns(randomDataSize);
 
     auto generateRandomData = [&](std::vector<int>& vec) {
         for (auto& val : vec) {
@@ -239,6 +1179,33 @@ int main() {
         }
         };
 
+    // 已排序的主体后追加一小段有序数据，只与主体末尾交叠
+    auto generateAppendedTailData = [&](std::vector<int>& vec) {
+        int bodySize = (int)vec.size() - (int)vec.size() / 20;
+        for (int i = 0; i < bodySize; ++i) {
+            vec[i] = 2 * i;
+        }
+        std::uniform_int_distribution<int> tailDist(2 * bodySize - bodySize / 10, 2 * bodySize);
+        for (int i = bodySize; i < (int)vec.size(); ++i) {
+            vec[i] = tailDist(gen) | 1;
+        }
+        std::sort(vec.begin() + bodySize, vec.end());
+        };
+
+    // 长度差异很大的有序运行，用于比较不同合并策略
+    auto generateIrregularRunsData = [&](std::vector<int>& vec) {
+        std::geometric_distribution<int> runDist(0.002);
+        int current = 0;
+        while (current < (int)vec.size()) {
+            int runEnd = std::min(current + 1 + runDist(gen), (int)vec.size());
+            for (int i = current; i < runEnd; ++i) {
+                vec[i] = dist(gen);
+            }
+            std::sort(vec.begin() + current, vec.begin() + runEnd);
+            current = runEnd;
+        }
+        };
+
     auto generateReversedData = [&](std::vector<int>& vec) {
         for (int i = 0; i < (int)vec.size(); ++i) {
             vec[i] = (int)vec.size() - i;
@@ -271,7 +1238,11 @@ int main() {
     std::vector<SortAlgorithm> sortingAlgorithms = {
         { "std::sort", [&](std::vector<int>& vec) { std::sort(vec.begin(), vec.end()); } },
         { "std::stable_sort", [&](std::vector<int>& vec) { std::stable_sort(vec.begin(), vec.end()); } },
-        { "Timsort", [&](std::vector<int>& vec) { timsort(vec.begin(), vec.end(), std::less<int>()); } },
+        // 带上下文的重载只使用合并引擎，用于比较合并策略；adaptive 行是可能改用基数排序的默认入口
+        { "Timsort", [&](std::vector<int>& vec) { timsort_context<int> ctx; timsort(vec.begin(), vec.end(), std::less<int>(), ctx); } },
+        { "Timsort (Powersort)", [&](std::vector<int>& vec) { timsort_context<int> ctx; timsort<timsort_powersort_policy>(vec.begin(), vec.end(), std::less<int>(), ctx); } },
+        { "Timsort (adaptive)", [&](std::vector<int>& vec) { timsort(vec.begin(), vec.end()); } },
+        { "Timsort (in-place)", [&](std::vector<int>& vec) { timsort_inplace(vec.begin(), vec.end(), std::less<int>()); } },
         { "QuickSort", [&](std::vector<int>& vec) { quickSort(vec.begin(), vec.end(), std::less<int>()); } },
     };
 
@@ -292,6 +1263,14 @@ int main() {
     for (const auto& algo : sortingAlgorithms) {
         measureTime(algo.func, algo.name, dataManyRuns);
     }
+    {
+        // 统计比较次数，跳跃模式应使块状数据的比较次数明显少于元素个数乘以合并层数
+        long long comparisons = 0;
+        std::vector<int> data = dataManyRuns;
+        timsort(data.begin(), data.end(), [&](int a, int b) { ++comparisons; return a < b; });
+        assert(std::is_sorted(data.begin(), data.end()));
+        std::cout << "Timsort comparisons: " << comparisons << std::endl;
+    }
 
     generateReversedData(dataReversed);
     std::cout << "\nSpecial Test Case: Reversed Data\n";
@@ -299,5 +1278,76 @@ int main() {
         measureTime(algo.func, algo.name, dataReversed);
     }
 
+    generateAppendedTailData(dataAppendedTail);
+    std::cout << "\nSpecial Test Case: Appended Sorted Tail Data\n";
+    for (const auto& algo : sortingAlgorithms) {
+        measureTime(algo.func, algo.name, dataAppendedTail);
+    }
+
+    generateIrregularRunsData(dataIrregularRuns);
+    std::cout << "\nSpecial Test Case: Irregular Runs Data\n";
+    for (const auto& algo : sortingAlgorithms) {
+        measureTime(algo.func, algo.name, dataIrregularRuns);
+    }
+
+    std::cout << "\n--- Context Reuse Test ---\n";
+    benchmarkContextReuse();
+
+    std::cout << "\n--- Scratch Memory Cap Test ---\n";
+    benchmarkScratchCap();
+
+    std::cout << "\n--- Run Detection Test ---\n";
+    benchmarkRunDetection();
+
+    std::cout << "\n--- Merge Kernel Test ---\n";
+    benchmarkMergeKernel();
+
+    std::cout << "\n--- Branchless Merge Test ---\n";
+    benchmarkBranchlessMerge();
+
+    std::cout << "\n--- Bidirectional Merge Test ---\n";
+    benchmarkBidirectionalMerge();
+
+    std::cout << "\n--- Sort By Key Test ---\n";
+    benchmarkSortByKey();
+
+    std::cout << "\n--- Indices Test ---\n";
+    benchmarkIndices();
+
+    std::cout << "\n--- Zip Sort Test ---\n";
+    benchmarkZip();
+
+    std::cout << "\n--- String Sort Test ---\n";
+    benchmarkStrings();
+
+    std::cout << "\n--- Radix Fallback Test ---\n";
+    benchmarkRadixFallback();
+
+    std::cout << "\n--- Parallel Scaling Test ---\n";
+    benchmarkParallelScaling();
+#if defined(__cpp_lib_execution)
+    std::cout << "\n--- Execution Policy Test ---\n";
+    benchmarkExecutionPolicies();
+#endif
+
+    std::cout << "\n--- Correctness Tests ---\n";
+    testNonDefaultConstructible();
+    testSmallSortPaths();
+    testArenaSortNoGlobalNew();
+    testInplaceNoAllocation();
+#if __cplusplus >= 202002L
+    testCallerScratchNoAllocation();
+#endif
+    testParallelCustomExecutor();
+    testIndicesAndPermutation();
+    testZipLengthMismatch();
+    testZipStability();
+
+    if (runLarge) {
+        std::cout << "\n--- Large Data Tests ---\n";
+        testHugeSparseArray();
+        benchmarkLargePrefetch();
+    }
+
     return 0;
 }